@@ -0,0 +1,43 @@
+#include "AllocationCounter.hpp"
+
+#ifndef NDEBUG
+
+#include <cstdlib>
+#include <new>
+
+//per-thread so other threads (e.g., the simulation thread) don't show up in the count:
+static thread_local uint64_t allocations = 0;
+
+uint64_t heap_allocation_count() {
+	return allocations;
+}
+
+//replacements for the global allocation functions that count calls.
+// (array and nothrow versions forward to these by default)
+void *operator new(std::size_t size) {
+	allocations += 1;
+	if (size == 0) size = 1;
+	while (true) {
+		void *ptr = std::malloc(size);
+		if (ptr) return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+#else
+
+uint64_t heap_allocation_count() {
+	return 0;
+}
+
+#endif
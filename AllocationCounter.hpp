@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+//Number of heap allocations (operator new) made so far by the calling thread.
+// Used to check that code that should be allocation-free really is.
+//NOTE: only counted in debug builds (when NDEBUG isn't defined); always 0 otherwise.
+uint64_t heap_allocation_count();
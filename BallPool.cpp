@@ -0,0 +1,174 @@
+#include "BallPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+constexpr uint32_t BallPool::TrailPoints;
+
+void BallPool::clear() {
+	x.clear();
+	y.clear();
+	vx.clear();
+	vy.clear();
+	trail_x.clear();
+	trail_y.clear();
+	trail_count = 0;
+	trail_next = 0;
+}
+
+void BallPool::add(glm::vec2 const &position, glm::vec2 const &velocity) {
+	x.emplace_back(position.x);
+	y.emplace_back(position.y);
+	vx.emplace_back(velocity.x);
+	vy.emplace_back(velocity.y);
+	//trail layout depends on size(), so start trails over:
+	trail_count = 0;
+	trail_next = 0;
+}
+
+void BallPool::move(float elapsed) {
+	float step = elapsed * speed;
+	size_t count = size();
+	for (size_t b = 0; b < count; ++b) {
+		x[b] += step * vx[b];
+		y[b] += step * vy[b];
+	}
+}
+
+uint32_t BallPool::collide_rect(glm::vec2 const &center, glm::vec2 const &half_size, bool warp) {
+	//same rules as PongMode's rect_vs_ball:
+	glm::vec2 reach = half_size + glm::vec2(radius);
+	uint32_t hits = 0;
+	size_t count = size();
+	for (size_t b = 0; b < count; ++b) {
+		float dx = x[b] - center.x;
+		float dy = y[b] - center.y;
+		if (std::abs(dx) > reach.x || std::abs(dy) > reach.y) continue;
+		hits += 1;
+
+		//overlap along each axis:
+		float overlap_x = std::min(center.x + half_size.x, x[b] + radius) - std::max(center.x - half_size.x, x[b] - radius);
+		float overlap_y = std::min(center.y + half_size.y, y[b] + radius) - std::max(center.y - half_size.y, y[b] - radius);
+
+		float speed_before = (warp ? std::sqrt(vx[b] * vx[b] + vy[b] * vy[b]) : 0.0f);
+		if (overlap_x > overlap_y) {
+			//wider overlap in x => bounce in y direction:
+			if (dy > 0.0f) {
+				y[b] = center.y + reach.y;
+				vy[b] = std::abs(vy[b]);
+			} else {
+				y[b] = center.y - reach.y;
+				vy[b] = -std::abs(vy[b]);
+			}
+			if (warp) vx[b] = glm::mix(vx[b], dx / reach.x, 0.75f);
+		} else {
+			//wider overlap in y => bounce in x direction:
+			if (dx > 0.0f) {
+				x[b] = center.x + reach.x;
+				vx[b] = std::abs(vx[b]);
+			} else {
+				x[b] = center.x - reach.x;
+				vx[b] = -std::abs(vx[b]);
+			}
+			if (warp) vy[b] = glm::mix(vy[b], dy / reach.y, 0.75f);
+		}
+		if (warp) {
+			//keep speed the same after warping direction:
+			float scale = speed_before / std::sqrt(vx[b] * vx[b] + vy[b] * vy[b]);
+			vx[b] *= scale;
+			vy[b] *= scale;
+		}
+	}
+	return hits;
+}
+
+void BallPool::collide_bounds(glm::vec2 const &bounds) {
+	glm::vec2 limit = bounds - glm::vec2(radius);
+	size_t count = size();
+	for (size_t b = 0; b < count; ++b) {
+		if (x[b] > limit.x) { x[b] = limit.x; vx[b] = -std::abs(vx[b]); }
+		if (x[b] < -limit.x) { x[b] = -limit.x; vx[b] = std::abs(vx[b]); }
+		if (y[b] > limit.y) { y[b] = limit.y; vy[b] = -std::abs(vy[b]); }
+		if (y[b] < -limit.y) { y[b] = -limit.y; vy[b] = std::abs(vy[b]); }
+	}
+}
+
+void BallPool::collide_balls(glm::vec2 const &bounds) {
+	size_t count = size();
+	if (count < 2) return;
+
+	//grid cells are one ball across, so touching balls are always in the same or neighboring cells:
+	float cell_size = 2.0f * radius;
+	int32_t cells_x = std::max(1, int32_t(std::ceil(2.0f * bounds.x / cell_size)));
+	int32_t cells_y = std::max(1, int32_t(std::ceil(2.0f * bounds.y / cell_size)));
+	auto cell_coord = [&](float v, float bound, int32_t cells) {
+		return std::min(cells - 1, std::max(0, int32_t((v + bound) / cell_size)));
+	};
+
+	//counting sort of balls by cell:
+	cell_start.assign(size_t(cells_x) * cells_y + 1, 0);
+	ball_cell.resize(count);
+	for (size_t b = 0; b < count; ++b) {
+		uint32_t cell = uint32_t(cell_coord(y[b], bounds.y, cells_y) * cells_x + cell_coord(x[b], bounds.x, cells_x));
+		ball_cell[b] = cell;
+		cell_start[cell + 1] += 1;
+	}
+	for (size_t c = 1; c < cell_start.size(); ++c) {
+		cell_start[c] += cell_start[c - 1];
+	}
+	//(cell_start[c] is now where cell c begins; use a copy as a per-cell write cursor)
+	cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+	cell_balls.resize(count);
+	for (size_t b = 0; b < count; ++b) {
+		cell_balls[cell_fill[ball_cell[b]]++] = uint32_t(b);
+	}
+
+	float min_dist = 2.0f * radius;
+	for (size_t i = 0; i < count; ++i) {
+		int32_t cx = int32_t(ball_cell[i] % uint32_t(cells_x));
+		int32_t cy = int32_t(ball_cell[i] / uint32_t(cells_x));
+		for (int32_t ny = std::max(0, cy - 1); ny <= std::min(cells_y - 1, cy + 1); ++ny) {
+			for (int32_t nx = std::max(0, cx - 1); nx <= std::min(cells_x - 1, cx + 1); ++nx) {
+				uint32_t cell = uint32_t(ny * cells_x + nx);
+				for (uint32_t k = cell_start[cell]; k < cell_start[cell + 1]; ++k) {
+					uint32_t j = cell_balls[k];
+					if (j <= i) continue; //each pair once
+
+					float dx = x[j] - x[i];
+					float dy = y[j] - y[i];
+					float dist2 = dx * dx + dy * dy;
+					if (dist2 >= min_dist * min_dist || dist2 == 0.0f) continue;
+
+					float dist = std::sqrt(dist2);
+					float nx_ = dx / dist, ny_ = dy / dist;
+					//push apart:
+					float push = 0.5f * (min_dist - dist);
+					x[i] -= nx_ * push; y[i] -= ny_ * push;
+					x[j] += nx_ * push; y[j] += ny_ * push;
+					//equal masses, elastic: exchange velocity along the normal if approaching:
+					float approach = (vx[j] - vx[i]) * nx_ + (vy[j] - vy[i]) * ny_;
+					if (approach < 0.0f) {
+						vx[i] += approach * nx_; vy[i] += approach * ny_;
+						vx[j] -= approach * nx_; vy[j] -= approach * ny_;
+					}
+				}
+			}
+		}
+	}
+}
+
+void BallPool::record_trail(double now) {
+	size_t count = size();
+	if (trail_count != 0) {
+		double newest = trail_time[(trail_next + TrailPoints - 1) % TrailPoints];
+		if (now - newest < trail_length / TrailPoints) return;
+	}
+	trail_x.resize(TrailPoints * count);
+	trail_y.resize(TrailPoints * count);
+	std::copy(x.begin(), x.end(), trail_x.begin() + trail_next * count);
+	std::copy(y.begin(), y.end(), trail_y.begin() + trail_next * count);
+	trail_time[trail_next] = now;
+	trail_next = (trail_next + 1) % TrailPoints;
+	trail_count = std::min(trail_count + 1, TrailPoints);
+}
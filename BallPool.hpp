@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <stdint.h>
+
+/*
+ * BallPool holds any number of extra balls, structure-of-arrays (one vector per field,
+ *  indexed by ball), so that each collision routine is one tight loop over every ball.
+ *
+ * Static geometry is handled one shape at a time across all balls (collide_rect, collide_bounds);
+ *  ball-vs-ball collisions find candidate pairs with a uniform grid (collide_balls).
+ * Balls all have the same radius and mass.
+ *
+ * Trails are sampled for every ball at the same moments (every trail_length / TrailPoints seconds),
+ *  so they share one ring of timestamps.
+ */
+
+struct BallPool {
+	void clear();
+	void add(glm::vec2 const &position, glm::vec2 const &velocity);
+	size_t size() const { return x.size(); }
+
+	//----- simulation -----
+	void move(float elapsed);
+	//bounce every ball off a rectangle; 'warp' bends the bounce based on where the ball hit (like paddles do).
+	//returns the number of balls that hit it:
+	uint32_t collide_rect(glm::vec2 const &center, glm::vec2 const &half_size, bool warp);
+	//keep every ball inside [-bounds, bounds]:
+	void collide_bounds(glm::vec2 const &bounds);
+	//bounce balls off each other (balls outside [-bounds, bounds] are treated as being on its edge for the broadphase):
+	void collide_balls(glm::vec2 const &bounds);
+	//record trail positions (if it's time for a new sample):
+	void record_trail(double now);
+
+	float radius = 0.2f;
+	float speed = 4.5f; //velocities are scaled by this when moving (same as the main ball)
+
+	std::vector< float > x, y; //positions
+	std::vector< float > vx, vy; //velocities (before 'speed')
+
+	//----- trails -----
+	static constexpr uint32_t TrailPoints = 8;
+	float trail_length = 1.3f;
+	//trail_x[k * size() + b] is ball b's position at trail_time[k]:
+	std::vector< float > trail_x, trail_y;
+	double trail_time[TrailPoints];
+	uint32_t trail_count = 0; //valid samples
+	uint32_t trail_next = 0; //slot the next sample goes into
+
+	//----- broadphase scratch (kept between calls to avoid reallocating) -----
+	std::vector< uint32_t > cell_start; //balls in cell c are cell_balls[cell_start[c]] .. cell_balls[cell_start[c+1]-1]
+	std::vector< uint32_t > cell_balls;
+	std::vector< uint32_t > ball_cell;
+	std::vector< uint32_t > cell_fill;
+};
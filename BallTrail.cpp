@@ -0,0 +1,67 @@
+#include "BallTrail.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+BallTrail::BallTrail(float length_, float max_rate) : length(length_), min_spacing(1.0 / max_rate) {
+	assert(length > 0.0f && max_rate > 0.0f);
+	//enough points to cover 'length' at 'max_rate', plus the one older point kept for interpolation, plus slack:
+	points.resize(size_t(std::ceil(length * max_rate)) + 3);
+}
+
+void BallTrail::restart(glm::vec2 const &position, double now) {
+	first = 0;
+	count = 2;
+	points[0].position = position;
+	points[0].time = now - length;
+	points[1].position = position;
+	points[1].time = now;
+}
+
+void BallTrail::push(glm::vec2 const &position, double now) {
+	assert(count == 0 || now >= (*this)[count - 1].time);
+
+	if (count >= 2 && now - (*this)[count - 2].time < min_spacing) {
+		//arriving faster than planned for: move the newest point rather than adding one:
+		Point &newest = points[(first + count - 1) % points.size()];
+		newest.position = position;
+		newest.time = now;
+	} else {
+		if (count == points.size()) {
+			//(shouldn't happen given min_spacing, but never overrun the buffer)
+			first = (first + 1) % points.size();
+			count -= 1;
+		}
+		Point &added = points[(first + count) % points.size()];
+		added.position = position;
+		added.time = now;
+		count += 1;
+	}
+
+	//drop too-old points:
+	//NOTE: since sampling interpolates between points, only drops the oldest point if the second-oldest is too old:
+	while (count >= 2 && (*this)[1].time < now - length) {
+		first = (first + 1) % points.size();
+		count -= 1;
+	}
+}
+
+glm::vec2 BallTrail::sample(double when) const {
+	assert(count >= 2);
+	//binary search for the first point (after the oldest) at or after 'when':
+	size_t lo = 1, hi = count - 1;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if ((*this)[mid].time < when) lo = mid + 1;
+		else hi = mid;
+	}
+	//interpolate between it and the point before:
+	Point const &a = (*this)[lo - 1];
+	Point const &b = (*this)[lo];
+	if (b.time == a.time) return b.position;
+	float amt = float((when - a.time) / (b.time - a.time));
+	//times outside the trail clamp to its ends (rather than extrapolating past them):
+	amt = std::min(1.0f, std::max(0.0f, amt));
+	return amt * (b.position - a.position) + a.position;
+}
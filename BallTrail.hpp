@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * BallTrail remembers where the ball has been recently, in a fixed-capacity ring buffer.
+ *
+ * Points store the (absolute) simulation time at which they were recorded, so nothing
+ *  has to be aged each update, and sample() finds the pair of points around a given time
+ *  with a binary search.
+ *
+ * The capacity is chosen from the trail length and the fastest rate points are expected to
+ *  arrive at; points that arrive faster than that replace the newest point instead of
+ *  being added, so the buffer never overflows (the trail just gets coarser).
+ */
+
+struct BallTrail {
+	struct Point {
+		glm::vec2 position;
+		double time;
+	};
+
+	//keep 'length' seconds of trail, with room for points arriving up to 'max_rate' times per second:
+	BallTrail(float length = 1.3f, float max_rate = 240.0f);
+
+	//set up trail as if the ball has been at 'position' for 'forever':
+	void restart(glm::vec2 const &position, double now);
+	//add the ball's position at time 'now' (>= the newest point's time) and drop points that are too old:
+	void push(glm::vec2 const &position, double now);
+
+	//position of the ball at time 'when' (interpolated between the points around it;
+	// times before the oldest point or after the newest get that point's position):
+	//NOTE: requires size() >= 2
+	glm::vec2 sample(double when) const;
+
+	size_t size() const { return count; }
+	//i = 0 is the oldest point:
+	Point const &operator[](size_t i) const { return points[(first + i) % points.size()]; }
+
+	float length;
+	double min_spacing; //points closer together than this (in time) get merged
+
+	//----- internals -----
+	std::vector< Point > points; //ring storage; size is the capacity
+	size_t first = 0; //index of oldest point in 'points'
+	size_t count = 0; //number of valid points
+};
@@ -0,0 +1,72 @@
+#include "CircleProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+#include <string>
+
+constexpr uint32_t CircleProgram::MaxRings;
+
+CircleProgram::CircleProgram() {
+	std::string max_rings = std::to_string(MaxRings);
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec4 Position;\n"
+		"in vec4 Color;\n"
+		"in vec2 Local;\n"
+		"in vec2 Rings;\n"
+		"out vec4 color;\n"
+		"out vec2 local;\n"
+		"flat out ivec2 rings;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	color = Color;\n"
+		"	local = Local;\n"
+		"	rings = ivec2(Rings);\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform vec4 RING_COLORS[" + max_rings + "];\n"
+		"uniform float RING_RADII[" + max_rings + "];\n"
+		"in vec4 color;\n"
+		"in vec2 local;\n"
+		"flat in ivec2 rings;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	float d = length(local);\n"
+		"	float aa = max(fwidth(d), 1e-6);\n" //distance (in radii) across one pixel
+		"	vec4 c = color;\n"
+		"	if (rings.y > 0) {\n"
+		//rings are outermost first, so walk inward until past the pixel:
+		"		c = RING_COLORS[rings.x];\n"
+		"		for (int k = 1; k < rings.y; ++k) {\n"
+		"			float t = clamp((RING_RADII[rings.x + k] - d) / aa + 0.5, 0.0, 1.0);\n"
+		"			if (t == 0.0) break;\n"
+		"			c = mix(c, RING_COLORS[rings.x + k], t);\n"
+		"		}\n"
+		"	}\n"
+		"	fragColor = vec4(c.rgb, c.a * clamp((1.0 - d) / aa + 0.5, 0.0, 1.0));\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Position_vec4 = glGetAttribLocation(program, "Position");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+	Local_vec2 = glGetAttribLocation(program, "Local");
+	Rings_vec2 = glGetAttribLocation(program, "Rings");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	RING_COLORS_vec4_array = glGetUniformLocation(program, "RING_COLORS");
+	RING_RADII_float_array = glGetUniformLocation(program, "RING_RADII");
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+CircleProgram::~CircleProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <stdint.h>
+
+//Shader program that draws circles as quads, computing coverage from the distance to the center
+// (so edges are anti-aliased and a circle costs two triangles no matter how big it is).
+//Circles can also be a set of concentric rings, with ring colors and radii taken from the RING_* uniform arrays:
+struct CircleProgram {
+	CircleProgram();
+	~CircleProgram();
+
+	GLuint program = 0;
+
+	//size of the RING_COLORS / RING_RADII uniform arrays:
+	static constexpr uint32_t MaxRings = 32;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U;
+	GLuint Color_vec4 = -1U; //color of solid circles
+	GLuint Local_vec2 = -1U; //position relative to the center, in radii (the edge is where length(Local) == 1)
+	GLuint Rings_vec2 = -1U; //(first, count) entries of the ring arrays; count == 0 draws a solid circle with Color
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint RING_COLORS_vec4_array = -1U; //ring colors, outermost first
+	GLuint RING_RADII_float_array = -1U; //outer radius of each ring, as a fraction of the circle's radius
+};
@@ -0,0 +1,41 @@
+#include "ColorProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+ColorProgram::ColorProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec4 Position;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Position_vec4 = glGetAttribLocation(program, "Position");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+ColorProgram::~ColorProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GL.hpp"
+
+//Shader program that draws transformed vertices with vertex colors (no texture):
+// (used with PongMode::CompactVertex, whose positions are fixed-point; OBJECT_TO_CLIP includes the scale)
+struct ColorProgram {
+	ColorProgram();
+	~ColorProgram();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U;
+	GLuint Color_vec4 = -1U;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+};
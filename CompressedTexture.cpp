@@ -0,0 +1,399 @@
+#include "CompressedTexture.hpp"
+
+#include "GL.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+//S3TC formats come from EXT_texture_compression_s3tc (not core), so aren't in GL.hpp:
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+uint32_t CompressedTexture::block_bytes(Format format) {
+	return (format == BC1 || format == BC4) ? 8 : 16;
+}
+
+size_t CompressedTexture::level_bytes(Format format, glm::uvec2 const &size) {
+	return size_t((size.x + 3) / 4) * ((size.y + 3) / 4) * block_bytes(format);
+}
+
+//----- color blocks (BC1, and the color half of BC3) -----
+// uint16_t color0, color1 (RGB 5:6:5), then 2-bit palette indices (texel i at bits 2i):
+//  color0 > color1: palette is color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+//  otherwise: color0, color1, 1/2 color0 + 1/2 color1, transparent black (BC1 only; BC3 always uses the first palette)
+
+static uint16_t to_565(glm::vec3 const &color) {
+	glm::vec3 c = glm::clamp(color, glm::vec3(0.0f), glm::vec3(255.0f));
+	uint16_t r = uint16_t(std::round(c.r * (31.0f / 255.0f)));
+	uint16_t g = uint16_t(std::round(c.g * (63.0f / 255.0f)));
+	uint16_t b = uint16_t(std::round(c.b * (31.0f / 255.0f)));
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static glm::uvec4 from_565(uint16_t color) {
+	uint32_t r = (color >> 11) & 0x1f;
+	uint32_t g = (color >> 5) & 0x3f;
+	uint32_t b = color & 0x1f;
+	return glm::uvec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0xff);
+}
+
+static void color_palette(uint16_t c0, uint16_t c1, bool four_color, glm::u8vec4 palette[4]) {
+	glm::uvec4 a = from_565(c0);
+	glm::uvec4 b = from_565(c1);
+	palette[0] = glm::u8vec4(a);
+	palette[1] = glm::u8vec4(b);
+	if (four_color) {
+		palette[2] = glm::u8vec4((2U * a + b) / 3U);
+		palette[3] = glm::u8vec4((a + 2U * b) / 3U);
+	} else {
+		palette[2] = glm::u8vec4((a + b) / 2U);
+		palette[3] = glm::u8vec4(0x00);
+	}
+}
+
+//'punch_through' (BC1) encodes pixels with alpha < 128 as transparent black:
+static void encode_color_block(glm::u8vec4 const pixels[16], bool punch_through, uint8_t out[8]) {
+	bool transparent[16];
+	bool any_transparent = false;
+	uint32_t opaque = 0;
+	glm::vec3 mean = glm::vec3(0.0f);
+	for (uint32_t i = 0; i < 16; ++i) {
+		transparent[i] = (punch_through && pixels[i].a < 128);
+		any_transparent = any_transparent || transparent[i];
+		if (!transparent[i]) {
+			mean += glm::vec3(pixels[i]);
+			opaque += 1;
+		}
+	}
+
+	uint16_t c0 = 0, c1 = 0;
+	if (opaque != 0) {
+		mean /= float(opaque);
+
+		//principal axis of the colors (power iteration on their covariance):
+		float xx = 0.0f, xy = 0.0f, xz = 0.0f, yy = 0.0f, yz = 0.0f, zz = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i) {
+			if (transparent[i]) continue;
+			glm::vec3 d = glm::vec3(pixels[i]) - mean;
+			xx += d.x * d.x; xy += d.x * d.y; xz += d.x * d.z;
+			yy += d.y * d.y; yz += d.y * d.z; zz += d.z * d.z;
+		}
+		glm::vec3 axis = glm::vec3(1.0f, 1.0f, 1.0f);
+		for (uint32_t iter = 0; iter < 8; ++iter) {
+			axis = glm::vec3(
+				xx * axis.x + xy * axis.y + xz * axis.z,
+				xy * axis.x + yy * axis.y + yz * axis.z,
+				xz * axis.x + yz * axis.y + zz * axis.z
+			);
+			float length = glm::length(axis);
+			if (!(length > 1e-6f)) {
+				axis = glm::vec3(0.0f); //(all one color)
+				break;
+			}
+			axis /= length;
+		}
+
+		//endpoints at the extremes of the colors along that axis:
+		float t_min = 0.0f, t_max = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i) {
+			if (transparent[i]) continue;
+			float t = glm::dot(glm::vec3(pixels[i]) - mean, axis);
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+		c0 = to_565(mean + t_max * axis);
+		c1 = to_565(mean + t_min * axis);
+	}
+
+	//order the endpoints to pick the palette (transparency needs the three-color one):
+	if ((c0 < c1) != any_transparent) std::swap(c0, c1);
+	bool four_color = !punch_through || c0 > c1;
+	glm::u8vec4 palette[4];
+	color_palette(c0, c1, four_color, palette);
+
+	uint32_t indices = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t best = 3;
+		if (!transparent[i]) {
+			int32_t best_distance = 0x7fffffff;
+			for (uint32_t p = 0; p < (four_color ? 4U : 3U); ++p) {
+				glm::ivec3 d = glm::ivec3(pixels[i]) - glm::ivec3(palette[p]);
+				int32_t distance = d.x * d.x + d.y * d.y + d.z * d.z;
+				if (distance < best_distance) {
+					best_distance = distance;
+					best = p;
+				}
+			}
+		}
+		indices |= best << (2 * i);
+	}
+
+	out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+	out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+	for (uint32_t b = 0; b < 4; ++b) {
+		out[4 + b] = uint8_t(indices >> (8 * b));
+	}
+}
+
+static void decode_color_block(uint8_t const in[8], bool punch_through, glm::u8vec4 pixels[16]) {
+	uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+	uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+	uint32_t indices = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+	glm::u8vec4 palette[4];
+	color_palette(c0, c1, !punch_through || c0 > c1, palette);
+	for (uint32_t i = 0; i < 16; ++i) {
+		pixels[i] = palette[(indices >> (2 * i)) & 3];
+	}
+}
+
+//----- single-channel blocks (BC4, and alpha in BC3, and each channel of BC5) -----
+// uint8_t value0, value1, then 3-bit palette indices (texel i at bits 3i):
+//  value0 > value1: value0, value1, and six evenly spaced values between them
+//  otherwise: value0, value1, four values between them, 0, 255
+
+static void value_palette(uint8_t v0, uint8_t v1, uint8_t palette[8]) {
+	palette[0] = v0;
+	palette[1] = v1;
+	if (v0 > v1) {
+		for (uint32_t i = 2; i < 8; ++i) {
+			palette[i] = uint8_t(((8 - i) * v0 + (i - 1) * v1 + 3) / 7);
+		}
+	} else {
+		for (uint32_t i = 2; i < 6; ++i) {
+			palette[i] = uint8_t(((6 - i) * v0 + (i - 1) * v1 + 2) / 5);
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void encode_value_block(uint8_t const values[16], uint8_t out[8]) {
+	uint8_t lo = 255, hi = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		lo = std::min(lo, values[i]);
+		hi = std::max(hi, values[i]);
+	}
+	//(hi > lo uses the eight-value palette; hi == lo only needs index 0)
+	uint8_t palette[8];
+	value_palette(hi, lo, palette);
+
+	uint64_t indices = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t best = 0;
+		int32_t best_distance = 256;
+		for (uint32_t p = 0; p < 8; ++p) {
+			int32_t distance = std::abs(int32_t(values[i]) - int32_t(palette[p]));
+			if (distance < best_distance) {
+				best_distance = distance;
+				best = p;
+			}
+		}
+		indices |= uint64_t(best) << (3 * i);
+	}
+
+	out[0] = hi;
+	out[1] = lo;
+	for (uint32_t b = 0; b < 6; ++b) {
+		out[2 + b] = uint8_t(indices >> (8 * b));
+	}
+}
+
+static void decode_value_block(uint8_t const in[8], uint8_t values[16]) {
+	uint8_t palette[8];
+	value_palette(in[0], in[1], palette);
+	uint64_t indices = 0;
+	for (uint32_t b = 0; b < 6; ++b) {
+		indices |= uint64_t(in[2 + b]) << (8 * b);
+	}
+	for (uint32_t i = 0; i < 16; ++i) {
+		values[i] = palette[(indices >> (3 * i)) & 7];
+	}
+}
+
+//----- whole textures -----
+
+void CompressedTexture::encode(MipChain const &mips, Format format_) {
+	format = format_;
+	sizes = mips.sizes;
+	levels.assign(mips.levels.size(), std::vector< uint8_t >());
+	for (uint32_t level = 0; level < levels.size(); ++level) {
+		glm::uvec2 size = sizes[level];
+		glm::u8vec4 const *src = mips.levels[level].data();
+		std::vector< uint8_t > &dst = levels[level];
+		dst.resize(level_bytes(format, size));
+		uint8_t *out = dst.data();
+		for (uint32_t by = 0; by < size.y; by += 4) {
+			for (uint32_t bx = 0; bx < size.x; bx += 4) {
+				//gather the block (repeating the last row / column past the edge):
+				glm::u8vec4 pixels[16];
+				for (uint32_t y = 0; y < 4; ++y) {
+					for (uint32_t x = 0; x < 4; ++x) {
+						pixels[y * 4 + x] = src[size_t(std::min(by + y, size.y - 1)) * size.x + std::min(bx + x, size.x - 1)];
+					}
+				}
+				uint8_t values[16];
+				auto channel = [&pixels, &values](uint32_t c) -> uint8_t const * {
+					for (uint32_t i = 0; i < 16; ++i) {
+						values[i] = pixels[i][c];
+					}
+					return values;
+				};
+				if (format == BC1) {
+					encode_color_block(pixels, true, out);
+				} else if (format == BC3) {
+					encode_value_block(channel(3), out);
+					encode_color_block(pixels, false, out + 8);
+				} else if (format == BC4) {
+					encode_value_block(channel(0), out);
+				} else {
+					encode_value_block(channel(0), out);
+					encode_value_block(channel(1), out + 8);
+				}
+				out += block_bytes(format);
+			}
+		}
+	}
+}
+
+void CompressedTexture::decode(uint32_t level, std::vector< glm::u8vec4 > *data_) const {
+	std::vector< glm::u8vec4 > &data = *data_;
+	glm::uvec2 size = sizes.at(level);
+	data.assign(size_t(size.x) * size.y, glm::u8vec4(0x00, 0x00, 0x00, 0xff));
+	uint8_t const *in = levels.at(level).data();
+	for (uint32_t by = 0; by < size.y; by += 4) {
+		for (uint32_t bx = 0; bx < size.x; bx += 4) {
+			glm::u8vec4 pixels[16];
+			uint8_t values[16];
+			if (format == BC1) {
+				decode_color_block(in, true, pixels);
+			} else if (format == BC3) {
+				decode_color_block(in + 8, false, pixels);
+				decode_value_block(in, values);
+				for (uint32_t i = 0; i < 16; ++i) pixels[i].a = values[i];
+			} else {
+				decode_value_block(in, values);
+				for (uint32_t i = 0; i < 16; ++i) pixels[i] = glm::u8vec4(values[i], 0x00, 0x00, 0xff);
+				if (format == BC5) {
+					decode_value_block(in + 8, values);
+					for (uint32_t i = 0; i < 16; ++i) pixels[i].g = values[i];
+				}
+			}
+			//(parts of edge blocks past the image are dropped)
+			for (uint32_t y = 0; y < 4 && by + y < size.y; ++y) {
+				for (uint32_t x = 0; x < 4 && bx + x < size.x; ++x) {
+					data[size_t(by + y) * size.x + bx + x] = pixels[y * 4 + x];
+				}
+			}
+			in += block_bytes(format);
+		}
+	}
+}
+
+//does the current context have EXT_texture_compression_s3tc?
+static bool have_s3tc() {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+		if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) return true;
+	}
+	return false;
+}
+
+void CompressedTexture::upload() const {
+	GLenum internal_format = 0;
+	if (format == BC1) internal_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	else if (format == BC3) internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	else if (format == BC4) internal_format = GL_COMPRESSED_RED_RGTC1;
+	else internal_format = GL_COMPRESSED_RG_RGTC2;
+
+	//(checked once, since drivers don't grow extensions)
+	static bool const s3tc = have_s3tc();
+	bool decompress = ((format == BC1 || format == BC3) && !s3tc);
+
+	std::vector< glm::u8vec4 > data;
+	for (uint32_t level = 0; level < levels.size(); ++level) {
+		if (decompress) {
+			decode(level, &data);
+			glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA, sizes[level].x, sizes[level].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		} else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, GLint(level), internal_format, sizes[level].x, sizes[level].y, 0, GLsizei(levels[level].size()), levels[level].data());
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+}
+
+//File layout (all values little-endian, as written by the machine that compressed them):
+// char magic[4] = "ctex"
+// uint32_t version
+// uint32_t format (CompressedTexture::Format)
+// uint32_t level count
+// glm::uvec2 sizes[level count]
+// uint8_t blocks[...] for each level (level_bytes(format, size) each)
+
+static const char Magic[4] = {'c','t','e','x'};
+static const uint32_t Version = 1;
+
+void CompressedTexture::save(std::string const &filename) const {
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open compressed texture '" + filename + "' for writing.");
+	}
+	uint32_t file_format = format;
+	uint32_t count = uint32_t(levels.size());
+	file.write(Magic, sizeof(Magic));
+	file.write(reinterpret_cast< char const * >(&Version), sizeof(Version));
+	file.write(reinterpret_cast< char const * >(&file_format), sizeof(file_format));
+	file.write(reinterpret_cast< char const * >(&count), sizeof(count));
+	file.write(reinterpret_cast< char const * >(sizes.data()), sizes.size() * sizeof(sizes[0]));
+	for (auto const &level : levels) {
+		file.write(reinterpret_cast< char const * >(level.data()), level.size());
+	}
+	if (!file) {
+		throw std::runtime_error("Failed to write compressed texture '" + filename + "'.");
+	}
+}
+
+void CompressedTexture::load(std::string const &filename) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open compressed texture '" + filename + "'.");
+	}
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t file_format = 0;
+	uint32_t count = 0;
+	if (!file.read(magic, sizeof(magic))
+	 || !file.read(reinterpret_cast< char * >(&version), sizeof(version))
+	 || !file.read(reinterpret_cast< char * >(&file_format), sizeof(file_format))
+	 || !file.read(reinterpret_cast< char * >(&count), sizeof(count))) {
+		throw std::runtime_error("Failed to read compressed texture header from '" + filename + "'.");
+	}
+	if (std::string(magic, 4) != std::string(Magic, 4) || version != Version) {
+		throw std::runtime_error("File '" + filename + "' is not a version " + std::to_string(Version) + " compressed texture.");
+	}
+	if (!(file_format == BC1 || file_format == BC3 || file_format == BC4 || file_format == BC5) || count == 0 || count > 32) {
+		throw std::runtime_error("Compressed texture '" + filename + "' has an unknown format or level count.");
+	}
+	std::vector< glm::uvec2 > file_sizes(count);
+	if (!file.read(reinterpret_cast< char * >(file_sizes.data()), file_sizes.size() * sizeof(file_sizes[0]))) {
+		throw std::runtime_error("Compressed texture '" + filename + "' is truncated.");
+	}
+	std::vector< std::vector< uint8_t > > file_levels(count);
+	for (uint32_t level = 0; level < count; ++level) {
+		file_levels[level].resize(level_bytes(Format(file_format), file_sizes[level]));
+		if (!file.read(reinterpret_cast< char * >(file_levels[level].data()), file_levels[level].size())) {
+			throw std::runtime_error("Compressed texture '" + filename + "' is truncated.");
+		}
+	}
+	format = Format(file_format);
+	sizes = std::move(file_sizes);
+	levels = std::move(file_levels);
+}
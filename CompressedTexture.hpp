@@ -0,0 +1,54 @@
+#pragma once
+
+#include "MipChain.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * CompressedTexture holds a texture (and its mipmaps) in a GPU block-compressed format,
+ *  so it can be handed to glCompressedTexImage2D as-is: 4-8x less memory and upload
+ *  bandwidth than the 32-bit RGBA that load_png produces.
+ *
+ * Formats (each encodes 4x4 pixel blocks):
+ *  BC1 (S3TC DXT1): RGB + 1-bit alpha, 8 bytes per block
+ *  BC3 (S3TC DXT5): RGBA, 16 bytes per block
+ *  BC4 (RGTC1): red only, 8 bytes per block
+ *  BC5 (RGTC2): red + green, 16 bytes per block
+ * RGTC is core in GL 3.0; S3TC comes from EXT_texture_compression_s3tc, which essentially
+ *  every desktop driver has -- if it's missing, upload() decodes on the CPU instead.
+ *
+ * Textures are compressed offline (see compress_texture.cpp, built as pongoria-compress)
+ *  by encode(), which fits each block's endpoints along its colors' principal axis.
+ */
+
+struct CompressedTexture {
+	enum Format : uint32_t {
+		BC1 = 1,
+		BC3 = 3,
+		BC4 = 4,
+		BC5 = 5,
+	};
+	Format format = BC1;
+	//per level, from largest to 1x1; rows of blocks start at the bottom (like the MipChain they came from):
+	std::vector< glm::uvec2 > sizes; //in pixels
+	std::vector< std::vector< uint8_t > > levels;
+
+	static uint32_t block_bytes(Format format); //8 or 16
+	static size_t level_bytes(Format format, glm::uvec2 const &size);
+
+	//compress every level of 'mips' (which should already be built):
+	void encode(MipChain const &mips, Format format);
+	//decompress one level back to RGBA (BC4 gives (r, 0, 0, 255) and BC5 (r, g, 0, 255), as GL samples them):
+	void decode(uint32_t level, std::vector< glm::u8vec4 > *data) const;
+
+	//upload every level to the texture bound to GL_TEXTURE_2D:
+	void upload() const;
+
+	//NOTE: save and load will throw on error
+	void save(std::string const &filename) const;
+	void load(std::string const &filename);
+};
@@ -0,0 +1,62 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+FrameArena::FrameArena(size_t initial_capacity) : capacity(initial_capacity) {
+}
+
+FrameArena::~FrameArena() {
+	//(not reset(), which would allocate a bigger block if the last frame overflowed)
+	while (overflow) {
+		Overflow *next = overflow->next;
+		::operator delete(overflow);
+		overflow = next;
+	}
+	::operator delete(block);
+}
+
+void *FrameArena::allocate(size_t bytes, size_t alignment) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "alignment should be a power of two");
+
+	if (!block) {
+		block = static_cast< char * >(::operator new(capacity));
+		heap_blocks += 1;
+	}
+
+	//try the main block first:
+	size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (start + bytes <= capacity) {
+		used += (start - offset) + bytes;
+		offset = start + bytes;
+		return block + start;
+	}
+
+	//doesn't fit; get a separate block for this allocation:
+	size_t header = (sizeof(Overflow) + alignment - 1) & ~(alignment - 1);
+	char *extra = static_cast< char * >(::operator new(header + bytes));
+	heap_blocks += 1;
+	Overflow *link = reinterpret_cast< Overflow * >(extra);
+	link->next = overflow;
+	overflow = link;
+	used += header + bytes;
+	return extra + header;
+}
+
+void FrameArena::reset() {
+	if (overflow) {
+		//last frame didn't fit; replace everything with one block that would have held it all:
+		while (overflow) {
+			Overflow *next = overflow->next;
+			::operator delete(overflow);
+			overflow = next;
+		}
+		::operator delete(block);
+		capacity = std::max(capacity * 2, used + used / 2);
+		block = static_cast< char * >(::operator new(capacity));
+		heap_blocks += 1;
+	}
+	offset = 0;
+	used = 0;
+}
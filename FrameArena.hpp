@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * FrameArena is a linear allocator for scratch memory that only lives for one frame:
+ *  allocate() bumps a pointer, individual frees do nothing, and reset() (called by main
+ *  at the start of every frame) throws everything away at once.
+ *
+ * If a frame needs more than the arena holds, extra blocks come from the heap; the next
+ *  reset() replaces everything with one block big enough for that frame, so in steady state
+ *  the arena never touches the heap.
+ *
+ * Use ArenaVector< T > (a std::vector backed by the arena) for per-frame containers.
+ */
+
+struct FrameArena {
+	explicit FrameArena(size_t initial_capacity = 256 * 1024);
+	~FrameArena();
+	FrameArena(FrameArena const &) = delete;
+	FrameArena &operator=(FrameArena const &) = delete;
+
+	void *allocate(size_t bytes, size_t alignment);
+	void reset();
+
+	size_t used = 0; //bytes allocated since the last reset (including alignment padding)
+	uint64_t heap_blocks = 0; //blocks ever requested from the heap (handy for checking that a frame didn't)
+
+	//----- internals -----
+	char *block = nullptr; //main block (allocated on first use)
+	size_t capacity = 0; //size of main block
+	size_t offset = 0; //first free byte in main block
+	struct Overflow {
+		Overflow *next;
+	};
+	Overflow *overflow = nullptr; //extra blocks allocated this frame (each starts with this header)
+};
+
+//std-compatible allocator that takes memory from a FrameArena:
+template< typename T >
+struct ArenaAllocator {
+	typedef T value_type;
+
+	ArenaAllocator(FrameArena &arena_) : arena(&arena_) { }
+	template< typename U >
+	ArenaAllocator(ArenaAllocator< U > const &other) : arena(other.arena) { }
+
+	T *allocate(size_t n) {
+		return static_cast< T * >(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *, size_t) {
+		//memory comes back at the next FrameArena::reset()
+	}
+
+	FrameArena *arena;
+};
+
+template< typename T, typename U >
+bool operator==(ArenaAllocator< T > const &a, ArenaAllocator< U > const &b) { return a.arena == b.arena; }
+template< typename T, typename U >
+bool operator!=(ArenaAllocator< T > const &a, ArenaAllocator< U > const &b) { return a.arena != b.arena; }
+
+template< typename T >
+using ArenaVector = std::vector< T, ArenaAllocator< T > >;
@@ -0,0 +1,113 @@
+#include "FramePacer.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+constexpr uint32_t FramePacer::Window;
+constexpr float FramePacer::HitchFactor;
+
+FramePacer::FramePacer(Target target_, float rate_hz_) : target(target_), rate_hz(rate_hz_) {
+	assert(rate_hz > 0.0f);
+	frame_ms.reserve(Window);
+}
+
+void FramePacer::apply_swap_interval(float display_hz) {
+	if (display_hz > 0.0f && target != FixedRate) {
+		rate_hz = display_hz;
+	}
+
+	if (target == VSync) {
+		//Set VSYNC + Late Swap (prevents crazy FPS):
+		if (SDL_GL_SetSwapInterval(-1) == 0) return;
+		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
+		if (SDL_GL_SetSwapInterval(1) == 0) return;
+		std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << "); pacing to " << rate_hz << " fps instead." << std::endl;
+		//rather than spinning as fast as possible:
+		target = FixedRate;
+	}
+
+	//FixedRate and Uncapped don't want the swap to block:
+	if (SDL_GL_SetSwapInterval(0) != 0) {
+		std::cerr << "NOTE: couldn't turn off vsync (" << SDL_GetError() << ")." << std::endl;
+	}
+}
+
+void FramePacer::end_frame() {
+	Clock::time_point now = Clock::now();
+	if (!started) {
+		started = true;
+		last_frame = next_deadline = last_log = now;
+		return;
+	}
+
+	if (target == FixedRate) {
+		Clock::duration period = std::chrono::duration_cast< Clock::duration >(std::chrono::duration< double >(1.0 / rate_hz));
+		next_deadline += period;
+		if (now > next_deadline + period) {
+			//fell more than a frame behind (hitch, suspend, ...); start over rather than rushing frames out:
+			next_deadline = now;
+		} else {
+			//sleep most of the way (sleep wakeups are imprecise), then spin for the rest:
+			if (next_deadline - now > spin_margin) {
+				std::this_thread::sleep_until(next_deadline - spin_margin);
+			}
+			while (Clock::now() < next_deadline) {
+				//spin
+			}
+			now = Clock::now();
+		}
+	}
+
+	float ms = std::chrono::duration< float, std::milli >(now - last_frame).count();
+	last_frame = now;
+	if (frame_ms.size() < Window) {
+		frame_ms.emplace_back(ms);
+	} else {
+		frame_ms[next_sample] = ms;
+	}
+	next_sample = (next_sample + 1) % Window;
+	if (ms > HitchFactor * 1000.0f / rate_hz && target != Uncapped) total_hitches += 1;
+
+	if (log_interval > 0.0f && std::chrono::duration< float >(now - last_log).count() >= log_interval) {
+		print_stats(std::cout);
+		last_log = now;
+	}
+}
+
+FramePacer::Stats FramePacer::stats() const {
+	Stats stats;
+	if (frame_ms.empty()) return stats;
+
+	std::vector< float > sorted = frame_ms;
+	std::sort(sorted.begin(), sorted.end());
+	auto percentile = [&](float p) {
+		return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+	};
+
+	stats.frames = uint32_t(sorted.size());
+	double total = 0.0;
+	for (float ms : sorted) total += ms;
+	stats.mean_ms = float(total / sorted.size());
+	stats.p50_ms = percentile(0.5f);
+	stats.p95_ms = percentile(0.95f);
+	stats.p99_ms = percentile(0.99f);
+	stats.max_ms = sorted.back();
+
+	//uncapped frames have no target, so compare against the typical frame instead:
+	float expected_ms = (target == Uncapped ? stats.p50_ms : 1000.0f / rate_hz);
+	stats.hitches = uint32_t(sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), HitchFactor * expected_ms));
+	return stats;
+}
+
+void FramePacer::print_stats(std::ostream &out) const {
+	Stats s = stats();
+	const char *names[3] = {"vsync", "fixed", "uncapped"};
+	out << "Frame times (" << names[target];
+	if (target != Uncapped) out << " " << rate_hz << " fps";
+	out << ", last " << s.frames << " frames): mean " << s.mean_ms << " ms, p50 " << s.p50_ms << " ms, p95 " << s.p95_ms
+		<< " ms, p99 " << s.p99_ms << " ms, max " << s.max_ms << " ms, " << s.hitches << " hitches (" << total_hitches << " total)." << std::endl;
+}
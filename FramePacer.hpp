@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * FramePacer decides when the main loop starts its next frame and keeps
+ *  rolling frame-time statistics.
+ *
+ * Targets:
+ *  VSync - let SDL_GL_SwapWindow block (late swap tearing if available);
+ *          if the driver refuses vsync, falls back to FixedRate at the display refresh rate.
+ *  FixedRate - sleep (then spin for the last little bit, for precision) until the next frame is due.
+ *  Uncapped - run as fast as possible.
+ */
+
+struct FramePacer {
+	enum Target {
+		VSync,
+		FixedRate,
+		Uncapped,
+	};
+	FramePacer(Target target, float rate_hz);
+
+	//set the swap interval for 'target' (needs a current GL context);
+	// 'display_hz' is used as the fixed rate if vsync isn't available:
+	void apply_swap_interval(float display_hz);
+
+	//call right after SDL_GL_SwapWindow; waits until the next frame should start (FixedRate) and records the frame time:
+	void end_frame();
+
+	struct Stats {
+		uint32_t frames = 0; //frames in the window
+		float mean_ms = 0.0f;
+		float p50_ms = 0.0f, p95_ms = 0.0f, p99_ms = 0.0f;
+		float max_ms = 0.0f;
+		uint32_t hitches = 0; //frames that took more than HitchFactor x the expected frame time
+	};
+	//statistics over the last (up to) Window frames:
+	Stats stats() const;
+	void print_stats(std::ostream &out) const;
+
+	Target target;
+	float rate_hz; //frame rate for FixedRate (also the expected rate used to spot hitches)
+
+	static constexpr uint32_t Window = 600; //frames kept for statistics
+	static constexpr float HitchFactor = 1.5f;
+
+	//how long before a deadline to stop sleeping and start spinning:
+	std::chrono::microseconds spin_margin = std::chrono::microseconds(1500);
+
+	//log stats every this many seconds (0 = never):
+	float log_interval = 0.0f;
+
+	//----- internals -----
+	std::vector< float > frame_ms; //ring buffer of recent frame times
+	uint32_t next_sample = 0; //next slot of frame_ms to write
+	uint64_t total_hitches = 0; //hitches since start (not counted when Uncapped)
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point last_frame;
+	Clock::time_point next_deadline; //FixedRate: when the next frame is due
+	Clock::time_point last_log;
+	bool started = false;
+};
@@ -0,0 +1,131 @@
+#include "GymServer.hpp"
+
+#include "GymShm.hpp"
+#include "PongMode.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <new>
+
+static void observe(PongMode const &pong, uint64_t step, GymObservation *obs) {
+	obs->step = step;
+	obs->ball[0] = pong.ball.x;
+	obs->ball[1] = pong.ball.y;
+	obs->ball_velocity[0] = pong.ball_velocity.x;
+	obs->ball_velocity[1] = pong.ball_velocity.y;
+	glm::vec2 const *paddles[9] = {
+		&pong.starting_paddle,
+		&pong.left_paddle, &pong.right_paddle, &pong.bottom_paddle, &pong.top_paddle,
+		&pong.left_far_paddle, &pong.right_far_paddle, &pong.bottom_far_paddle, &pong.top_far_paddle,
+	};
+	for (uint32_t p = 0; p < 9; ++p) {
+		obs->paddles[p][0] = paddles[p]->x;
+		obs->paddles[p][1] = paddles[p]->y;
+	}
+	obs->area = (pong.starting_area ? 0 : (pong.ending_area ? 2 : 1));
+	obs->flipped = pong.state_flipped ? 1 : 0;
+	obs->rainbow = pong.state_rainbow ? 1 : 0;
+
+	std::vector< PongMode::Brick > const &bricks = (pong.state_flipped ? pong.bricks_flipped : pong.bricks);
+	obs->brick_count = uint32_t(std::min< size_t >(bricks.size(), GymObservation::MaxBricks));
+	std::memset(obs->live_bricks, 0, sizeof(obs->live_bricks));
+	for (uint32_t b = 0; b < obs->brick_count; ++b) {
+		if (!bricks[b].deleted) obs->live_bricks[b / 32] |= (1u << (b % 32));
+	}
+}
+
+int run_gym_server(std::string const &name) {
+	std::string shm_name = "/" + name;
+
+	//create (or re-create) the shared memory object:
+	shm_unlink(shm_name.c_str());
+	int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		std::cerr << "Failed to create shared memory '" << shm_name << "': " << strerror(errno) << std::endl;
+		return 1;
+	}
+	if (ftruncate(fd, sizeof(GymShared)) != 0) {
+		std::cerr << "Failed to size shared memory '" << shm_name << "': " << strerror(errno) << std::endl;
+		close(fd);
+		shm_unlink(shm_name.c_str());
+		return 1;
+	}
+	void *mapping = mmap(nullptr, sizeof(GymShared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		std::cerr << "Failed to map shared memory '" << shm_name << "': " << strerror(errno) << std::endl;
+		shm_unlink(shm_name.c_str());
+		return 1;
+	}
+	GymShared *shared = new (mapping) GymShared();
+	shared->actions_written.store(0);
+	shared->observations_written.store(0);
+	shared->server_pid.store(uint32_t(getpid()));
+	shared->client_pid.store(0);
+	shared->version = GymShared::Version;
+	//writing magic last lets clients know the rest is initialized:
+	std::atomic_thread_fence(std::memory_order_release);
+	shared->magic = GymShared::Magic;
+
+	std::cout << "Gym server listening on shared memory '" << shm_name << "'." << std::endl;
+
+	std::unique_ptr< PongMode > pong(new PongMode(false));
+	const char *title = "";
+	Mode::Window_settings window_settings = Mode::Window_settings(glm::uvec2(800, 800), glm::uvec2(0, 0), 1.0f, &title);
+	uint64_t step = 0;
+
+	uint32_t handled = 0; //actions processed so far
+	bool quit = false;
+	int result = 0;
+	while (!quit) {
+		uint32_t written;
+		if (!gym_wait_change(shared->actions_written, handled, shared->client_pid, &written)) {
+			std::cerr << "Gym client (pid " << shared->client_pid.load() << ") exited without sending Quit; shutting down." << std::endl;
+			result = 1;
+			break;
+		}
+		//handle every action that is available:
+		while (handled != written) {
+			GymAction const &action = shared->actions[handled % GymShared::RingSize];
+			if (action.command == GymAction::Quit) {
+				quit = true;
+			} else if (action.command == GymAction::Reset) {
+				pong.reset(new PongMode(false));
+				step = 0;
+			} else {
+				//paddles follow absolute_mouse_pos + camera_pos, and update() first snaps the camera to the ball:
+				glm::vec2 camera = (pong->ending_area ? glm::vec2(0.0f) : pong->ball);
+				pong->absolute_mouse_pos = glm::vec2(action.target[0], action.target[1]) - camera;
+				pong->update(action.elapsed, window_settings);
+				step += 1;
+			}
+			observe(*pong, step, &shared->observations[handled % GymShared::RingSize]);
+			handled += 1;
+			gym_publish(shared->observations_written, handled);
+		}
+	}
+
+	munmap(mapping, sizeof(GymShared));
+	shm_unlink(shm_name.c_str());
+	std::cout << "Gym server shut down after " << handled << " actions." << std::endl;
+	return result;
+}
+
+#else
+
+int run_gym_server(std::string const &name) {
+	std::cerr << "The gym interface is only supported on Linux." << std::endl;
+	return 1;
+}
+
+#endif
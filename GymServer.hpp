@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+//Serve a headless PongMode over the shared-memory interface in GymShm.hpp.
+// creates shared memory object '/<name>', runs until a client sends GymAction::Quit,
+// and returns a process exit code. (Only supported on Linux.)
+int run_gym_server(std::string const &name);
@@ -0,0 +1,114 @@
+#pragma once
+
+/*
+ * Shared-memory layout for driving PongMode from another process ("gym" interface).
+ *
+ * The server (Pongoria --gym <name>) creates a POSIX shared memory object '/<name>'
+ *  holding one GymShared. The client pushes GymActions into a small ring and the
+ *  server answers each with a GymObservation in a matching ring. Both sides spin
+ *  briefly and then sleep on a futex, so a round trip costs microseconds rather than
+ *  a trip through the window system. Sleeps wake once a second to check that the
+ *  other side's process is still around, so neither hangs if its peer crashes.
+ *
+ * Linux only (futex).
+ */
+
+#include <atomic>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <cerrno>
+#endif
+
+struct GymAction {
+	enum Command : uint32_t {
+		Step = 0, //advance the game by 'elapsed' with paddles tracking 'target'
+		Reset = 1, //start a fresh game (target/elapsed ignored)
+		Quit = 2, //shut the server down
+	};
+	uint32_t command;
+	float elapsed; //seconds to simulate
+	float target[2]; //court-space point the paddles should track
+};
+
+struct GymObservation {
+	static constexpr uint32_t MaxBricks = 512;
+
+	uint64_t step; //number of steps taken since the last reset
+	float ball[2];
+	float ball_velocity[2];
+	//paddle centers: starting, left, right, bottom, top, left_far, right_far, bottom_far, top_far:
+	float paddles[9][2];
+	uint32_t area; //0 = starting, 1 = main, 2 = ending
+	uint32_t flipped;
+	uint32_t rainbow;
+	uint32_t brick_count; //number of valid bits in live_bricks
+	uint32_t live_bricks[MaxBricks / 32]; //bit b set if brick b (of the current, possibly flipped, set) is still there
+};
+
+struct GymShared {
+	static constexpr uint32_t Magic = 0x6d796770; //'pgym'
+	static constexpr uint32_t Version = 2;
+	static constexpr uint32_t RingSize = 16; //maximum actions in flight
+
+	uint32_t magic;
+	uint32_t version;
+
+	//process ids of each side (0 until that side has connected), so a waiter can tell a slow peer from a dead one:
+	std::atomic< uint32_t > server_pid; //written by server
+	std::atomic< uint32_t > client_pid; //written by client
+
+	//ring indices only ever increase; slot = index % RingSize.
+	//these are also the futex words that the other side sleeps on:
+	std::atomic< uint32_t > actions_written; //written by client
+	std::atomic< uint32_t > observations_written; //written by server
+
+	GymAction actions[RingSize];
+	GymObservation observations[RingSize];
+};
+static_assert(sizeof(std::atomic< uint32_t >) == sizeof(uint32_t), "futex words must be plain 32-bit values");
+
+#ifdef __linux__
+
+//is the process in 'pid' still running? (a side that hasn't connected yet counts as running)
+inline bool gym_peer_alive(std::atomic< uint32_t > const &pid) {
+	uint32_t id = pid.load(std::memory_order_acquire);
+	if (id == 0) return true;
+	return kill(pid_t(id), 0) == 0 || errno == EPERM;
+}
+
+//wait until 'word' no longer holds 'seen', spinning for a little while before sleeping in the kernel.
+//stores the new value in *value and returns true, or returns false if the process in 'peer_pid' goes away first:
+inline bool gym_wait_change(std::atomic< uint32_t > &word, uint32_t seen, std::atomic< uint32_t > const &peer_pid, uint32_t *value) {
+	for (uint32_t spin = 0; spin < 4000; ++spin) {
+		*value = word.load(std::memory_order_acquire);
+		if (*value != seen) return true;
+	}
+	while (true) {
+		*value = word.load(std::memory_order_acquire);
+		if (*value != seen) return true;
+		//shared (not FUTEX_PRIVATE) since the other side is another process:
+		struct timespec timeout;
+		timeout.tv_sec = 1;
+		timeout.tv_nsec = 0;
+		long ret = syscall(SYS_futex, reinterpret_cast< uint32_t * >(&word), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+		if (ret != 0 && errno == ETIMEDOUT && !gym_peer_alive(peer_pid)) {
+			//(one last look, in case it published just before exiting)
+			*value = word.load(std::memory_order_acquire);
+			return *value != seen;
+		}
+	}
+}
+
+//publish a new value of 'word' and wake whoever is waiting on it:
+inline void gym_publish(std::atomic< uint32_t > &word, uint32_t value) {
+	word.store(value, std::memory_order_release);
+	syscall(SYS_futex, reinterpret_cast< uint32_t * >(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+#endif
@@ -0,0 +1,181 @@
+#include "HeadlessGL.hpp"
+
+#include "gl_errors.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+
+//(keep eglplatform.h from pulling in Xlib.h, which #defines things like 'None' and 'Bool')
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <cstring>
+
+static std::string egl_error() {
+	char hex[16];
+	snprintf(hex, sizeof(hex), "0x%04x", unsigned(eglGetError()));
+	return std::string(hex);
+}
+
+static bool has_extension(char const *extensions, char const *name) {
+	if (!extensions) return false;
+	size_t len = strlen(name);
+	for (char const *at = strstr(extensions, name); at; at = strstr(at + len, name)) {
+		//must match a whole (space-separated) word:
+		if ((at == extensions || at[-1] == ' ') && (at[len] == ' ' || at[len] == '\0')) return true;
+	}
+	return false;
+}
+
+HeadlessGL::HeadlessGL(glm::uvec2 const &size_) : size(size_) {
+	if (size.x == 0 || size.y == 0) {
+		throw std::runtime_error("Headless framebuffer must be at least 1x1.");
+	}
+
+	//prefer the surfaceless platform, which needs no display server at all:
+	EGLDisplay egl_display = EGL_NO_DISPLAY;
+	if (has_extension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (get_platform_display) {
+			egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+	}
+	if (egl_display == EGL_NO_DISPLAY) {
+		egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (egl_display == EGL_NO_DISPLAY) {
+		throw std::runtime_error("Failed to get an EGL display (error " + egl_error() + ").");
+	}
+
+	EGLint major = 0, minor = 0;
+	if (!eglInitialize(egl_display, &major, &minor)) {
+		throw std::runtime_error("Failed to initialize EGL (error " + egl_error() + ").");
+	}
+	display = egl_display;
+
+	//past this point, failures need to clean up the display (and maybe context):
+	auto fail = [this](std::string const &message) {
+		if (context) eglDestroyContext(display, context);
+		eglTerminate(display);
+		throw std::runtime_error(message);
+	};
+
+	if (!has_extension(eglQueryString(egl_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+		fail("EGL " + std::to_string(major) + "." + std::to_string(minor) + " display doesn't support EGL_KHR_surfaceless_context.");
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		fail("EGL display doesn't support desktop OpenGL (error " + egl_error() + ").");
+	}
+
+	//any config that can do desktop GL; nothing gets drawn to an EGL surface, so surface type doesn't matter:
+	EGLint const config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_DONT_CARE,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint config_count = 0;
+	if (!eglChooseConfig(egl_display, config_attribs, &config, 1, &config_count) || config_count < 1) {
+		fail("No EGL config supports desktop OpenGL (error " + egl_error() + ").");
+	}
+
+	//same version + profile that main.cpp asks SDL for:
+	EGLint const context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (context == EGL_NO_CONTEXT) {
+		context = nullptr;
+		fail("Failed to create an OpenGL 3.3 core context (error " + egl_error() + ").");
+	}
+	if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		fail("Failed to make the headless context current (error " + egl_error() + ").");
+	}
+
+	//load OpenGL entrypoints (does nothing on Linux, but keeps the usual order of things):
+	init_GL();
+
+	//framebuffer to draw into:
+	glGenRenderbuffers(1, &color_renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &color_renderbuffer);
+		eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		fail("Headless framebuffer is incomplete (status " + std::to_string(status) + ").");
+	}
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+HeadlessGL::~HeadlessGL() {
+	glDeleteFramebuffers(1, &framebuffer);
+	framebuffer = 0;
+	glDeleteRenderbuffers(1, &color_renderbuffer);
+	color_renderbuffer = 0;
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, context);
+	context = nullptr;
+	eglTerminate(display);
+	display = nullptr;
+}
+
+void HeadlessGL::bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, size.x, size.y);
+}
+
+void HeadlessGL::finish() {
+	glFinish();
+}
+
+void HeadlessGL::read_pixels(std::vector< glm::u8vec4 > *data) {
+	data->resize(size_t(size.x) * size.y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, data->data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	for (auto &px : *data) {
+		px.a = 0xff;
+	}
+	GL_ERRORS();
+}
+
+#else
+
+HeadlessGL::HeadlessGL(glm::uvec2 const &size_) : size(size_) {
+	throw std::runtime_error("Headless rendering is only supported on Linux (it uses EGL).");
+}
+
+HeadlessGL::~HeadlessGL() {
+}
+
+void HeadlessGL::bind() {
+}
+
+void HeadlessGL::finish() {
+}
+
+void HeadlessGL::read_pixels(std::vector< glm::u8vec4 > *data) {
+	data->clear();
+}
+
+#endif
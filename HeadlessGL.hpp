@@ -0,0 +1,41 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * HeadlessGL creates an OpenGL 3.3 core context that isn't attached to any window,
+ *  plus a framebuffer object to render into, so frames can be drawn and read back
+ *  on machines with no display (e.g., CI runners using Mesa's llvmpipe).
+ *
+ * The context comes from EGL, using the surfaceless platform when available
+ *  (EGL_MESA_platform_surfaceless) and otherwise the default display.
+ * (Only supported on Linux.)
+ */
+
+struct HeadlessGL {
+	//NOTE: constructor will throw on error (e.g., no EGL, or no way to make a context without a surface)
+	HeadlessGL(glm::uvec2 const &size);
+	~HeadlessGL();
+
+	HeadlessGL(HeadlessGL const &) = delete;
+	HeadlessGL &operator=(HeadlessGL const &) = delete;
+
+	glm::uvec2 size;
+
+	//bind the framebuffer and set the viewport to cover it (do this before drawing):
+	void bind();
+	//wait for all drawing to finish (so timings include the GPU's work):
+	void finish();
+	//read back the framebuffer (rows start at the bottom, like glReadPixels; alpha is forced to opaque):
+	void read_pixels(std::vector< glm::u8vec4 > *data);
+
+	//----- internals -----
+	void *display = nullptr; //EGLDisplay
+	void *context = nullptr; //EGLContext
+	GLuint framebuffer = 0;
+	GLuint color_renderbuffer = 0;
+};
@@ -0,0 +1,83 @@
+#include "ImageDiff.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_DIFF_SSE
+#include <emmintrin.h>
+#endif
+
+//YIQ components (scaled 0-255):
+static glm::vec3 to_yiq(glm::u8vec4 const &c) {
+	float r = c.r, g = c.g, b = c.b;
+	return glm::vec3(
+		r * 0.29889531f + g * 0.58662247f + b * 0.11448223f,
+		r * 0.59597799f - g * 0.27417610f - b * 0.32180189f,
+		r * 0.21147017f - g * 0.52261711f + b * 0.31114694f
+	);
+}
+
+float color_delta(glm::u8vec4 const &a, glm::u8vec4 const &b) {
+	glm::vec3 d = to_yiq(a) - to_yiq(b);
+	float delta = 0.5053f * d.x * d.x + 0.299f * d.y * d.y + 0.1957f * d.z * d.z;
+	//(35215 is the delta between black and white)
+	return std::sqrt(delta / 35215.0f);
+}
+
+ImageDiffResult diff_images(size_t count, glm::u8vec4 const *a, glm::u8vec4 const *b, float threshold, std::vector< glm::u8vec4 > *diff) {
+	ImageDiffResult result;
+	if (diff) diff->resize(count);
+
+	//classify one pixel that isn't bit-identical:
+	auto compare = [&](size_t i) {
+		float delta = color_delta(a[i], b[i]);
+		result.max_delta = std::max(result.max_delta, delta);
+		if (delta > threshold) {
+			result.different += 1;
+			if (diff) (*diff)[i] = glm::u8vec4(0xff, 0x00, 0x00, 0xff);
+		} else {
+			result.similar += 1;
+			if (diff) (*diff)[i] = glm::u8vec4(0xff, 0xcc, 0x00, 0xff);
+		}
+	};
+	auto same = [&](size_t i) {
+		result.exact += 1;
+		if (diff) {
+			//faded gray, so differences stand out:
+			uint8_t y = uint8_t(std::min(255.0f, 0.1f * to_yiq(a[i]).x + 229.0f));
+			(*diff)[i] = glm::u8vec4(y, y, y, 0xff);
+		}
+	};
+	auto rgb_equal = [&](size_t i) {
+		return a[i].r == b[i].r && a[i].g == b[i].g && a[i].b == b[i].b;
+	};
+
+	size_t i = 0;
+#ifdef IMAGE_DIFF_SSE
+	//four pixels at a time; most blocks are identical and skip straight past:
+	__m128i const alpha_mask = _mm_set1_epi32(int32_t(0xff000000));
+	for (; i + 4 <= count; i += 4) {
+		__m128i va = _mm_or_si128(_mm_loadu_si128(reinterpret_cast< __m128i const * >(a + i)), alpha_mask);
+		__m128i vb = _mm_or_si128(_mm_loadu_si128(reinterpret_cast< __m128i const * >(b + i)), alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xffff) {
+			if (diff) {
+				for (size_t k = i; k < i + 4; ++k) same(k);
+			} else {
+				result.exact += 4;
+			}
+			continue;
+		}
+		for (size_t k = i; k < i + 4; ++k) {
+			if (rgb_equal(k)) same(k);
+			else compare(k);
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		if (rgb_equal(i)) same(i);
+		else compare(i);
+	}
+
+	return result;
+}
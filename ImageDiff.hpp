@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Compare two same-sized images, tolerating differences too small to see.
+ *
+ * Pixels are compared with a perceptual color distance (the YIQ-space metric from
+ *  pixelmatch, Kotsarenko & Ramos 2010), scaled so 0 is identical and 1 is black vs. white.
+ * Most pixels in a regression test are bit-identical, so those are skipped four at a time
+ *  with an SSE2 equality test before any distances are computed.
+ *
+ * Alpha is ignored (screenshots and renders are saved fully opaque).
+ */
+
+struct ImageDiffResult {
+	size_t exact = 0; //bit-identical (ignoring alpha)
+	size_t similar = 0; //not identical, but within the threshold
+	size_t different = 0; //beyond the threshold
+	float max_delta = 0.0f; //largest distance seen (0-1)
+};
+
+//perceptual distance between two colors (0 = same, 1 = black vs. white):
+float color_delta(glm::u8vec4 const &a, glm::u8vec4 const &b);
+
+//compare 'count' pixels of 'a' and 'b'; pixels with color_delta() > threshold are counted as different.
+//if 'diff' is non-null, it is filled with a visualization: a faded grayscale copy of 'a',
+// yellow where pixels differ within the threshold, and red where they differ beyond it.
+ImageDiffResult diff_images(size_t count, glm::u8vec4 const *a, glm::u8vec4 const *b, float threshold, std::vector< glm::u8vec4 > *diff = nullptr);
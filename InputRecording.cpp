@@ -0,0 +1,59 @@
+#include "InputRecording.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+//File layout (all values little-endian, as written by the machine that recorded them):
+// char magic[4] = "pngr"
+// uint32_t version
+// uint32_t extra ball count
+// uint32_t frame count
+// Frame frames[frame count]
+// uint32_t final checksum
+
+static const char Magic[4] = {'p','n','g','r'};
+static const uint32_t Version = 2; //(version 1 had no extra ball count)
+
+void InputRecording::save(std::string const &filename) const {
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open recording file '" + filename + "' for writing.");
+	}
+	uint32_t count = uint32_t(frames.size());
+	file.write(Magic, sizeof(Magic));
+	file.write(reinterpret_cast< char const * >(&Version), sizeof(Version));
+	file.write(reinterpret_cast< char const * >(&extra_ball_count), sizeof(extra_ball_count));
+	file.write(reinterpret_cast< char const * >(&count), sizeof(count));
+	file.write(reinterpret_cast< char const * >(frames.data()), frames.size() * sizeof(Frame));
+	file.write(reinterpret_cast< char const * >(&final_checksum), sizeof(final_checksum));
+	if (!file) {
+		throw std::runtime_error("Failed to write recording to '" + filename + "'.");
+	}
+}
+
+void InputRecording::load(std::string const &filename) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open recording file '" + filename + "'.");
+	}
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t count = 0;
+	if (!file.read(magic, sizeof(magic))
+	 || !file.read(reinterpret_cast< char * >(&version), sizeof(version))) {
+		throw std::runtime_error("Failed to read recording header from '" + filename + "'.");
+	}
+	if (std::string(magic, 4) != std::string(Magic, 4) || version != Version) {
+		throw std::runtime_error("File '" + filename + "' is not a version " + std::to_string(Version) + " recording.");
+	}
+	if (!file.read(reinterpret_cast< char * >(&extra_ball_count), sizeof(extra_ball_count))
+	 || !file.read(reinterpret_cast< char * >(&count), sizeof(count))) {
+		throw std::runtime_error("Failed to read recording header from '" + filename + "'.");
+	}
+	frames.resize(count);
+	if (!file.read(reinterpret_cast< char * >(frames.data()), frames.size() * sizeof(Frame))
+	 || !file.read(reinterpret_cast< char * >(&final_checksum), sizeof(final_checksum))) {
+		frames.clear();
+		throw std::runtime_error("Recording '" + filename + "' is truncated.");
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * InputRecording stores everything PongMode::update consumes from the outside world,
+ *  one entry per frame, so that a play session can be replayed bit-exactly
+ *  (either in a window or headless) for debugging and benchmarking.
+ */
+
+struct InputRecording {
+	struct Frame {
+		float elapsed; //'elapsed' value passed to Mode::update
+		glm::vec2 mouse; //court-space mouse position (PongMode::absolute_mouse_pos) at the start of update
+		uint32_t seed; //seed for Mode::rng, applied right before update
+	};
+	static_assert(sizeof(Frame) == 4 + 4*2 + 4, "InputRecording::Frame should be packed");
+
+	//PongMode::extra_ball_count the session was played with (replays must use the same):
+	uint32_t extra_ball_count = 0;
+
+	std::vector< Frame > frames;
+
+	//PongMode::state_checksum() after the last frame; used to check that a replay didn't diverge:
+	uint32_t final_checksum = 0;
+
+	//NOTE: load will throw on error
+	void save(std::string const &filename) const;
+	void load(std::string const &filename);
+};
@@ -0,0 +1,86 @@
+#include "LatencyTracker.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <iostream>
+
+void LatencyTracker::note_input(uint32_t timestamp) {
+	pending.emplace_back(timestamp);
+	newest_input = timestamp;
+}
+
+void LatencyTracker::input_used() {
+	if (pending.empty()) return;
+	input_used(pending.back());
+}
+
+void LatencyTracker::input_used(uint32_t through) {
+	//(signed difference handles SDL_GetTicks wrapping around)
+	while (!pending.empty() && int32_t(through - pending.front()) >= 0) {
+		if (!frame_has_input) {
+			frame_oldest = pending.front();
+			frame_has_input = true;
+		}
+		frame_newest = pending.front();
+		pending.pop_front();
+	}
+}
+
+void LatencyTracker::before_swap() {
+	if (fence) glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void LatencyTracker::after_swap() {
+	uint32_t swapped = SDL_GetTicks();
+	if (fence) {
+		//wait (up to a second) for the GPU to finish the frame:
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	uint32_t finished = SDL_GetTicks();
+
+	if (frame_has_input) {
+		Sample sample;
+		//(unsigned differences handle SDL_GetTicks wrapping around)
+		sample.newest_to_swap = float(uint32_t(swapped - frame_newest));
+		sample.newest_to_gpu = float(uint32_t(finished - frame_newest));
+		sample.oldest_to_gpu = float(uint32_t(finished - frame_oldest));
+		samples.emplace_back(sample);
+		frame_has_input = false;
+	}
+
+	if (report_interval > 0.0f && uint32_t(finished - last_report) >= uint32_t(report_interval * 1000.0f)) {
+		if (last_report != 0) report(std::cout);
+		last_report = finished;
+	}
+}
+
+void LatencyTracker::report(std::ostream &out) {
+	if (samples.empty()) {
+		out << "Input latency: no mouse motion since last report." << std::endl;
+		return;
+	}
+
+	std::vector< float > values(samples.size());
+	auto summarize = [&](const char *name, float Sample::*member) {
+		for (size_t i = 0; i < samples.size(); ++i) {
+			values[i] = samples[i].*member;
+		}
+		std::sort(values.begin(), values.end());
+		auto percentile = [&](float p) {
+			return values[std::min(values.size() - 1, size_t(p * values.size()))];
+		};
+		out << "  " << name << ": p50 " << percentile(0.5f) << " ms, p95 " << percentile(0.95f)
+			<< " ms, p99 " << percentile(0.99f) << " ms, max " << values.back() << " ms" << std::endl;
+	};
+
+	out << "Input latency over " << samples.size() << " frames with mouse motion:" << std::endl;
+	summarize("newest event -> swap", &Sample::newest_to_swap);
+	summarize("newest event -> gpu done", &Sample::newest_to_gpu);
+	summarize("oldest event -> gpu done", &Sample::oldest_to_gpu);
+
+	samples.clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <deque>
+#include <iosfwd>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * LatencyTracker measures how long mouse motion takes to reach the screen.
+ *
+ * main calls:
+ *  note_input() for every SDL_MOUSEMOTION, with the event's timestamp,
+ *  input_used() when the frame about to be drawn actually reflects that input
+ *   (an update read the mouse, or, with a simulation thread, the drawn snapshot was stepped with it),
+ *  before_swap() once the frame has been drawn (inserts a GL fence),
+ *  after_swap() right after SDL_GL_SwapWindow (waits for the fence).
+ * Input that no drawn frame has used yet stays pending, so frames that didn't
+ *  step (or drew an older snapshot) don't get credited with it.
+ *
+ * Each frame that had input yields a sample measured from the newest event
+ *  (the position actually drawn) and from the oldest event (how stale input can get).
+ * "gpu" times are taken when the fence signals, i.e. when the GPU finished the frame,
+ *  which is the closest we can get to photons without external hardware.
+ *
+ * NOTE: SDL event timestamps are SDL_GetTicks() values, so everything here has
+ *  millisecond resolution. Waiting on the fence also stops the CPU from running
+ *  ahead of the GPU, so only enable this when measuring.
+ */
+
+struct LatencyTracker {
+	void note_input(uint32_t timestamp);
+	//the frame being drawn shows all input noted so far:
+	void input_used();
+	//the frame being drawn shows input noted up to (and including) timestamp 'through'; newer input stays pending:
+	void input_used(uint32_t through);
+	void before_swap();
+	void after_swap();
+
+	struct Sample {
+		float newest_to_swap; //ms from newest input event to SDL_GL_SwapWindow returning
+		float newest_to_gpu; //ms from newest input event to GPU completion
+		float oldest_to_gpu; //ms from oldest input event to GPU completion
+	};
+	std::vector< Sample > samples; //since the last report
+
+	//print percentiles of 'samples' (and clear them):
+	void report(std::ostream &out);
+	//report every this many seconds (0 = only when asked):
+	float report_interval = 5.0f;
+
+	//----- internals -----
+	std::deque< uint32_t > pending; //timestamps of input not yet drawn, oldest first
+	uint32_t newest_input = 0; //timestamp of the newest input noted (drawn or not)
+	bool frame_has_input = false; //the frame in flight uses input
+	uint32_t frame_oldest = 0, frame_newest = 0;
+	GLsync fence = 0;
+	uint32_t last_report = 0;
+};
@@ -0,0 +1,220 @@
+#include "MipChain.hpp"
+
+#include "GL.hpp"
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE
+#include <emmintrin.h>
+#endif
+
+MipChain::MipChain(glm::uvec2 const &size, std::vector< glm::u8vec4 > &&data) {
+	if (data.size() != size_t(size.x) * size.y) {
+		throw std::runtime_error("MipChain given " + std::to_string(data.size()) + " pixels for a " + std::to_string(size.x) + "x" + std::to_string(size.y) + " image.");
+	}
+	sizes.emplace_back(size);
+	levels.emplace_back(std::move(data));
+}
+
+//halve 'src' into 'dst' with a 2x2 box filter (rounding to nearest):
+static void downsample(glm::uvec2 const &src_size, glm::u8vec4 const *src, glm::uvec2 const &dst_size, glm::u8vec4 *dst) {
+	for (uint32_t y = 0; y < dst_size.y; ++y) {
+		//(a 1-pixel-tall source is averaged with itself)
+		glm::u8vec4 const *row0 = src + size_t(std::min(2 * y, src_size.y - 1)) * src_size.x;
+		glm::u8vec4 const *row1 = src + size_t(std::min(2 * y + 1, src_size.y - 1)) * src_size.x;
+		glm::u8vec4 *out = dst + size_t(y) * dst_size.x;
+		uint32_t x = 0;
+	#ifdef MIP_CHAIN_SSE
+		//four output pixels (eight input columns) at a time:
+		if (src_size.x >= 2) {
+			__m128i const zero = _mm_setzero_si128();
+			__m128i const two = _mm_set1_epi16(2);
+			for (; x + 4 <= dst_size.x; x += 4) {
+				__m128i sums[2];
+				for (uint32_t h = 0; h < 2; ++h) {
+					__m128i a = _mm_loadu_si128(reinterpret_cast< __m128i const * >(row0 + 2 * x + 4 * h));
+					__m128i b = _mm_loadu_si128(reinterpret_cast< __m128i const * >(row1 + 2 * x + 4 * h));
+					//column sums of pixels 0,1 and 2,3, as 16-bit channels:
+					__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+					__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+					//(0 + 1, 2 + 3):
+					sums[h] = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+					sums[h] = _mm_srli_epi16(_mm_add_epi16(sums[h], two), 2);
+				}
+				_mm_storeu_si128(reinterpret_cast< __m128i * >(out + x), _mm_packus_epi16(sums[0], sums[1]));
+			}
+		}
+	#endif
+		for (; x < dst_size.x; ++x) {
+			uint32_t x0 = std::min(2 * x, src_size.x - 1);
+			uint32_t x1 = std::min(2 * x + 1, src_size.x - 1);
+			glm::uvec4 sum = glm::uvec4(row0[x0]) + glm::uvec4(row0[x1]) + glm::uvec4(row1[x0]) + glm::uvec4(row1[x1]);
+			out[x] = glm::u8vec4((sum + glm::uvec4(2)) / 4U);
+		}
+	}
+}
+
+void MipChain::build() {
+	if (levels.empty()) {
+		throw std::runtime_error("MipChain::build() needs level 0.");
+	}
+	sizes.resize(1);
+	levels.resize(1);
+	while (sizes.back() != glm::uvec2(1, 1)) {
+		glm::uvec2 src_size = sizes.back();
+		glm::uvec2 dst_size = glm::max(src_size / 2U, glm::uvec2(1));
+		std::vector< glm::u8vec4 > dst(size_t(dst_size.x) * dst_size.y);
+		downsample(src_size, levels.back().data(), dst_size, dst.data());
+		sizes.emplace_back(dst_size);
+		levels.emplace_back(std::move(dst));
+	}
+}
+
+void MipChain::upload() const {
+	for (uint32_t level = 0; level < levels.size(); ++level) {
+		glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA, sizes[level].x, sizes[level].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[level].data());
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+}
+
+uint64_t MipChain::source_hash() const {
+	//FNV-1a, 64-bit:
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto add = [&hash](void const *data, size_t bytes) {
+		uint8_t const *begin = reinterpret_cast< uint8_t const * >(data);
+		for (uint8_t const *b = begin; b != begin + bytes; ++b) {
+			hash = (hash ^ *b) * 0x100000001b3ULL;
+		}
+	};
+	if (!levels.empty()) {
+		add(&sizes[0], sizeof(sizes[0]));
+		add(levels[0].data(), levels[0].size() * sizeof(levels[0][0]));
+	}
+	return hash;
+}
+
+//File layout (all values little-endian, as written by the machine that built them):
+// char magic[4] = "mips"
+// uint32_t version
+// uint64_t source hash (of level 0)
+// uint32_t level count
+// glm::uvec2 sizes[level count]
+// glm::u8vec4 pixels[...] for levels 1 .. level count - 1 (level 0 is the source image, so isn't stored)
+
+static const char Magic[4] = {'m','i','p','s'};
+static const uint32_t Version = 1;
+
+void MipChain::save(std::string const &filename) const {
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open mip cache '" + filename + "' for writing.");
+	}
+	uint64_t hash = source_hash();
+	uint32_t count = uint32_t(levels.size());
+	file.write(Magic, sizeof(Magic));
+	file.write(reinterpret_cast< char const * >(&Version), sizeof(Version));
+	file.write(reinterpret_cast< char const * >(&hash), sizeof(hash));
+	file.write(reinterpret_cast< char const * >(&count), sizeof(count));
+	file.write(reinterpret_cast< char const * >(sizes.data()), sizes.size() * sizeof(sizes[0]));
+	for (uint32_t level = 1; level < levels.size(); ++level) {
+		file.write(reinterpret_cast< char const * >(levels[level].data()), levels[level].size() * sizeof(levels[level][0]));
+	}
+	if (!file) {
+		throw std::runtime_error("Failed to write mip cache '" + filename + "'.");
+	}
+}
+
+void MipChain::load(std::string const &filename) {
+	if (levels.empty()) {
+		throw std::runtime_error("MipChain::load() needs level 0 (to check that '" + filename + "' was built from it).");
+	}
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open mip cache '" + filename + "'.");
+	}
+	char magic[4];
+	uint32_t version = 0;
+	uint64_t hash = 0;
+	uint32_t count = 0;
+	if (!file.read(magic, sizeof(magic))
+	 || !file.read(reinterpret_cast< char * >(&version), sizeof(version))
+	 || !file.read(reinterpret_cast< char * >(&hash), sizeof(hash))
+	 || !file.read(reinterpret_cast< char * >(&count), sizeof(count))) {
+		throw std::runtime_error("Failed to read mip cache header from '" + filename + "'.");
+	}
+	if (std::string(magic, 4) != std::string(Magic, 4) || version != Version) {
+		throw std::runtime_error("File '" + filename + "' is not a version " + std::to_string(Version) + " mip cache.");
+	}
+	if (hash != source_hash() || count == 0 || count > 32) {
+		throw std::runtime_error("Mip cache '" + filename + "' was built from a different image.");
+	}
+	std::vector< glm::uvec2 > file_sizes(count);
+	if (!file.read(reinterpret_cast< char * >(file_sizes.data()), file_sizes.size() * sizeof(file_sizes[0]))) {
+		throw std::runtime_error("Mip cache '" + filename + "' is truncated.");
+	}
+	if (file_sizes[0] != sizes[0]) {
+		throw std::runtime_error("Mip cache '" + filename + "' was built from a different image.");
+	}
+	std::vector< std::vector< glm::u8vec4 > > file_levels(count);
+	for (uint32_t level = 1; level < count; ++level) {
+		file_levels[level].resize(size_t(file_sizes[level].x) * file_sizes[level].y);
+		if (!file.read(reinterpret_cast< char * >(file_levels[level].data()), file_levels[level].size() * sizeof(file_levels[level][0]))) {
+			throw std::runtime_error("Mip cache '" + filename + "' is truncated.");
+		}
+	}
+	//everything read, so replace the levels:
+	file_levels[0] = std::move(levels[0]);
+	sizes = std::move(file_sizes);
+	levels = std::move(file_levels);
+}
+
+void build_mip_chains(std::vector< MipChain * > const &chains, uint32_t thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::max(1U, std::thread::hardware_concurrency());
+	}
+	thread_count = uint32_t(std::min< size_t >(thread_count, chains.size()));
+
+	//each thread takes the next unbuilt chain until there are none left:
+	std::atomic< size_t > next(0);
+	auto work = [&chains, &next]() {
+		for (size_t i = next++; i < chains.size(); i = next++) {
+			chains[i]->build();
+		}
+	};
+	//(the calling thread works too)
+	std::vector< std::thread > threads;
+	for (uint32_t t = 1; t < thread_count; ++t) {
+		threads.emplace_back(work);
+	}
+	work();
+	for (auto &thread : threads) {
+		thread.join();
+	}
+}
+
+void load_png_mips(std::string const &filename, std::string const &cache_filename, MipChain *chain_) {
+	MipChain &chain = *chain_;
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > data;
+	load_png(filename, &size, &data, LowerLeftOrigin);
+	chain = MipChain(size, std::move(data));
+
+	try {
+		chain.load(cache_filename);
+		return;
+	} catch (std::exception const &) {
+		//no usable cache; build the levels instead
+	}
+	chain.build();
+	try {
+		chain.save(cache_filename);
+	} catch (std::exception const &) {
+		//(not being able to write the cache just means building again next time)
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * MipChain builds a texture's mipmap levels on the CPU, at load time, so the GL thread
+ *  only has to upload them (rather than running glGenerateMipmap inside the driver).
+ *
+ * Levels are made with a 2x2 box filter (each level from the one before; odd rows and
+ *  columns at the edge are dropped, as when halving with integer division), four output
+ *  pixels at a time with SSE2 when available.
+ *
+ * build_mip_chains() builds several images' chains at once, one image per thread at a time,
+ *  and load_png_mips() keeps built levels in a cache file next to the image.
+ */
+
+struct MipChain {
+	MipChain() = default;
+	//just level 0 (call build() for the rest):
+	MipChain(glm::uvec2 const &size, std::vector< glm::u8vec4 > &&data);
+
+	//levels[0] is the original image (rows start at the bottom); each level after is half the size
+	// of the last (rounded down, but at least 1), down to 1x1:
+	std::vector< glm::uvec2 > sizes;
+	std::vector< std::vector< glm::u8vec4 > > levels;
+
+	//(re)build levels 1 and up from level 0:
+	void build();
+
+	//upload every level to the texture bound to GL_TEXTURE_2D:
+	void upload() const;
+
+	//NOTE: save and load will throw on error
+	void save(std::string const &filename) const;
+	void load(std::string const &filename);
+
+	//hash of level 0 (and its size), used to check that a cache file is for the same image:
+	uint64_t source_hash() const;
+};
+
+//build() all of 'chains' (which should each have level 0) using up to 'thread_count' threads:
+// (thread_count = 0 uses one thread per hardware core)
+void build_mip_chains(std::vector< MipChain * > const &chains, uint32_t thread_count = 0);
+
+//load a PNG (via load_png, with LowerLeftOrigin) and its mipmaps; levels come from 'cache_filename'
+// if it was built from the same image, and otherwise are built and written there.
+//NOTE: throws if the PNG can't be loaded (a missing, stale, or unwritable cache just means building the levels)
+void load_png_mips(std::string const &filename, std::string const &cache_filename, MipChain *chain);
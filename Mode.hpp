@@ -1,5 +1,8 @@
 #pragma once
 
+#include "PCG32.hpp"
+#include "FrameArena.hpp"
+
 #include <SDL.h>
 #include <glm/glm.hpp>
 
@@ -30,7 +33,17 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	virtual void update(float elapsed, Window_settings &window_settings) { }
 
 	//draw is called after update:
-	virtual void draw(glm::uvec2 const &drawable_size) = 0;
+	// 'alpha' is how far (0-1) the frame lies between the state before the most recent update and the current state
+	// (it is 1 unless main is running update at a fixed step; see --fixed-step)
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) = 0;
+
+	//random number generator owned by this mode:
+	// (modes should use this instead of rand() so they can be re-seeded for replays and run on separate threads)
+	PCG32 rng;
+
+	//scratch memory for things that only live for one frame (reset by main at the start of every frame):
+	// (draw() should build its temporary containers here rather than on the heap)
+	FrameArena frame_arena;
 
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * PCG32 is a small, fast pseudo-random number generator (PCG-XSH-RR, see pcg-random.org).
+ * Unlike rand(), each instance has its own state, so separate generators don't
+ *  interfere with each other and can be used from separate threads.
+ * Seeding is explicit, so sequences can be reproduced exactly (e.g., for replays).
+ */
+
+struct PCG32 {
+	//streams with different 'stream' values are independent even if 'seed' is the same:
+	explicit PCG32(uint64_t seed_ = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+		seed(seed_, stream);
+	}
+
+	void seed(uint64_t seed_, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+		state = 0;
+		increment = (stream << 1) | 1; //increment must be odd
+		(*this)();
+		state += seed_;
+		(*this)();
+	}
+
+	//next 32 random bits:
+	uint32_t operator()() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + increment;
+		uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+		uint32_t rot = uint32_t(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+
+	//uniformly distributed value in [0, bound) (multiply-shift; bias is negligible for small bounds):
+	uint32_t below(uint32_t bound) {
+		return uint32_t((uint64_t((*this)()) * bound) >> 32);
+	}
+
+	//uniformly distributed value in [0, 1):
+	float unit() {
+		return ((*this)() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//fill an array with random bits in one call:
+	void fill(uint32_t *out, size_t count) {
+		//local copies let the compiler keep the state in registers across the loop:
+		uint64_t s = state;
+		uint64_t const inc = increment;
+		for (size_t i = 0; i < count; ++i) {
+			uint64_t old = s;
+			s = old * 6364136223846793005ULL + inc;
+			uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+			uint32_t rot = uint32_t(old >> 59);
+			out[i] = (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+		}
+		state = s;
+	}
+
+	uint64_t state = 0;
+	uint64_t increment = 1;
+};
@@ -0,0 +1,302 @@
+#include "PongBatch.hpp"
+
+//the level layout is copied out of a (headless) PongMode so the two can't drift apart:
+#include "PongMode.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//games per cache line of the narrowest (uint8_t) state arrays;
+// partitions start on multiples of this so threads never write to the same cache line:
+static const size_t PartitionAlign = CacheLineAllocator< uint8_t >::Align;
+
+PongBatch::PongBatch(size_t count, uint32_t thread_count, uint32_t extra_ball_count_) : extra_ball_count(extra_ball_count_) {
+	{ //copy level layout from PongMode:
+		PongMode pong(false);
+		auto rect = [](glm::vec2 const &center, glm::vec2 const &radius) {
+			Rect r;
+			r.center = center;
+			r.radius = radius;
+			return r;
+		};
+		level.starting_walls = {
+			rect(pong.left_wall, pong.left_wall_rad),
+			rect(pong.right_wall, pong.right_wall_rad),
+			rect(pong.bottom_wall, pong.bottom_wall_rad),
+			rect(pong.top_wall, pong.top_wall_rad),
+			rect(pong.BL_wall, pong.BL_wall_rad),
+			rect(pong.BR_wall, pong.BR_wall_rad),
+			rect(pong.TR_wall, pong.TR_wall_rad),
+		};
+		level.ending_walls = {
+			rect(pong.left_end_wall, pong.left_end_wall_rad),
+			rect(pong.right_end_wall, pong.right_end_wall_rad),
+			rect(pong.bottom_end_wall, pong.bottom_end_wall_rad),
+			rect(pong.top_end_wall, pong.top_end_wall_rad),
+		};
+		level.blocks[0] = pong.TR_block;
+		level.blocks[1] = pong.BR_block;
+		level.blocks[2] = pong.BL_block;
+		level.blocks[3] = pong.TL_block;
+		level.block_radius = pong.block_radius;
+		for (auto const &brick : pong.bricks) {
+			level.bricks.emplace_back(rect(brick.Position, brick.Radius));
+		}
+		for (auto const &brick : pong.bricks_flipped) {
+			level.bricks_flipped.emplace_back(rect(brick.Position, brick.Radius));
+		}
+		for (auto const &poi : pong.POIs) {
+			Circle c;
+			static_cast< POIRule & >(c) = poi;
+			c.center = poi.Position;
+			c.radius = poi.Radius;
+			level.POIs.emplace_back(c);
+		}
+		level.vert_paddle_radius = pong.vert_paddle_radius;
+		level.horiz_paddle_radius = pong.horiz_paddle_radius;
+		level.ball_radius = pong.ball_radius;
+		level.ball_start = pong.ball;
+		level.velocity_start = pong.ball_velocity;
+		level.base_court_radius = pong.base_court_radius;
+		level.extreme_radius = pong.extreme_radius;
+		level.start_dist = pong.start_dist;
+		level.trail_length = pong.trail_length;
+		level.starting_paddle = pong.starting_paddle;
+		level.left_paddle = pong.left_paddle;
+		level.right_paddle = pong.right_paddle;
+		level.bottom_paddle = pong.bottom_paddle;
+		level.top_paddle = pong.top_paddle;
+		level.left_far_paddle = pong.left_far_paddle;
+		level.right_far_paddle = pong.right_far_paddle;
+		level.bottom_far_paddle = pong.bottom_far_paddle;
+		level.top_far_paddle = pong.top_far_paddle;
+	}
+	assert(level.bricks.size() == level.bricks_flipped.size());
+	brick_count = level.bricks.size();
+
+	//allocate per-game state:
+	ball_x.resize(count);
+	ball_y.resize(count);
+	velocity_x.resize(count);
+	velocity_y.resize(count);
+	area.resize(count);
+	flipped.resize(count);
+	rainbow.resize(count);
+	bounces.resize(count);
+	brick_deleted.resize(count * brick_count);
+	brick_flipped_deleted.resize(count * brick_count);
+	extra_balls.resize(count);
+	rng.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		rng.emplace_back(PCG32(0x853c49e6748fea9bULL, i));
+	}
+	for (size_t i = 0; i < count; ++i) {
+		reset(i);
+	}
+
+	//start worker threads:
+	if (thread_count == 0) {
+		thread_count = std::max(1U, std::thread::hardware_concurrency());
+	}
+	//no point in having partitions smaller than the alignment:
+	size_t max_partitions = std::max< size_t >(1, (count + PartitionAlign - 1) / PartitionAlign);
+	partitions = uint32_t(std::min< size_t >(thread_count, max_partitions));
+	//the calling thread runs partition zero; workers run the rest:
+	for (uint32_t p = 1; p < partitions; ++p) {
+		workers.emplace_back(&PongBatch::worker_main, this, p);
+	}
+}
+
+PongBatch::~PongBatch() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	work_cv.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void PongBatch::reset(size_t i) {
+	assert(i < size());
+	ball_x[i] = level.ball_start.x;
+	ball_y[i] = level.ball_start.y;
+	velocity_x[i] = level.velocity_start.x;
+	velocity_y[i] = level.velocity_start.y;
+	area[i] = StartingArea;
+	flipped[i] = 0;
+	rainbow[i] = 0;
+	bounces[i] = 0;
+	std::fill(brick_deleted.begin() + i * brick_count, brick_deleted.begin() + (i + 1) * brick_count, 0);
+	std::fill(brick_flipped_deleted.begin() + i * brick_count, brick_flipped_deleted.begin() + (i + 1) * brick_count, 0);
+	extra_balls[i].clear();
+}
+
+size_t PongBatch::partition_begin(uint32_t partition) const {
+	if (partition >= partitions) return size();
+	size_t chunks = (size() + PartitionAlign - 1) / PartitionAlign;
+	return std::min(size(), (chunks * partition / partitions) * PartitionAlign);
+}
+
+void PongBatch::step(float elapsed, glm::vec2 const *actions) {
+	if (!workers.empty()) {
+		std::unique_lock< std::mutex > lock(mutex);
+		current_elapsed = elapsed;
+		current_actions = actions;
+		working = uint32_t(workers.size());
+		generation += 1;
+	}
+	work_cv.notify_all();
+
+	step_range(partition_begin(0), partition_begin(1), elapsed, actions);
+
+	if (!workers.empty()) {
+		std::unique_lock< std::mutex > lock(mutex);
+		done_cv.wait(lock, [this](){ return working == 0; });
+	}
+}
+
+void PongBatch::worker_main(uint32_t partition) {
+	uint64_t seen_generation = 0;
+	while (true) {
+		float elapsed;
+		glm::vec2 const *actions;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			work_cv.wait(lock, [&](){ return quit || generation != seen_generation; });
+			if (quit) return;
+			seen_generation = generation;
+			elapsed = current_elapsed;
+			actions = current_actions;
+		}
+
+		step_range(partition_begin(partition), partition_begin(partition + 1), elapsed, actions);
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			working -= 1;
+		}
+		done_cv.notify_one();
+	}
+}
+
+void PongBatch::step_range(size_t begin, size_t end, float elapsed, glm::vec2 const *actions) {
+	Level const &L = level;
+
+	for (size_t g = begin; g < end; ++g) {
+		//load this game's state into locals:
+		glm::vec2 ball = glm::vec2(ball_x[g], ball_y[g]);
+		glm::vec2 velocity = glm::vec2(velocity_x[g], velocity_y[g]);
+		AreaState state;
+		state.starting_area = (area[g] == StartingArea);
+		state.ending_area = (area[g] == EndingArea);
+		state.flipped = (flipped[g] != 0);
+		state.rainbow = (rainbow[g] != 0);
+		uint32_t game_bounces = bounces[g];
+
+		auto rect_vs_ball = [&](glm::vec2 const &rect, glm::vec2 const &radius, bool velo_warp) {
+			if (!ball_vs_rect(rect, radius, velo_warp, L.ball_radius, &ball, &velocity)) return false;
+			game_bounces += 1;
+			return true;
+		};
+
+		//----- paddles -----
+		PaddlePlacement placement = place_paddles(actions[g], L.start_dist, L.base_court_radius, L.extreme_radius, L.vert_paddle_radius, L.horiz_paddle_radius);
+		MainAreaLayout main;
+		main.paddles[0] = glm::vec2(L.left_paddle.x, placement.near_y);
+		main.paddles[1] = glm::vec2(L.right_paddle.x, placement.near_y);
+		main.paddles[2] = glm::vec2(placement.near_x, L.bottom_paddle.y);
+		main.paddles[3] = glm::vec2(placement.near_x, L.top_paddle.y);
+		main.paddles[4] = glm::vec2(L.left_far_paddle.x, placement.far_y);
+		main.paddles[5] = glm::vec2(L.right_far_paddle.x, placement.far_y);
+		main.paddles[6] = glm::vec2(placement.far_x, L.bottom_far_paddle.y);
+		main.paddles[7] = glm::vec2(placement.far_x, L.top_far_paddle.y);
+		main.vert_paddle_radius = L.vert_paddle_radius;
+		main.horiz_paddle_radius = L.horiz_paddle_radius;
+		for (uint32_t b = 0; b < 4; ++b) {
+			main.blocks[b] = L.blocks[b];
+		}
+		main.block_radius = L.block_radius;
+		main.extreme_radius = L.extreme_radius;
+
+		//----- ball update -----
+		const float speed_multiplier = 4.5f;
+		ball += elapsed * speed_multiplier * velocity;
+
+		//----- collisions (in the same order as PongMode::update) -----
+		if (state.starting_area) {
+			rect_vs_ball(glm::vec2(placement.starting_x, L.starting_paddle.y), L.horiz_paddle_radius, true);
+			for (auto const &wall : L.starting_walls) {
+				rect_vs_ball(wall.center, wall.radius, false);
+			}
+		} else if (state.ending_area) {
+			for (auto const &wall : L.ending_walls) {
+				rect_vs_ball(wall.center, wall.radius, false);
+			}
+		} else {
+			for (uint32_t p = 0; p < 8; ++p) {
+				rect_vs_ball(main.paddles[p], (p % 4 < 2 ? L.vert_paddle_radius : L.horiz_paddle_radius), true);
+			}
+
+			//bricks:
+			std::vector< Rect > const &game_bricks = (state.flipped ? L.bricks_flipped : L.bricks);
+			uint8_t *deleted = (state.flipped ? brick_flipped_deleted.data() : brick_deleted.data()) + g * brick_count;
+			for (size_t b = 0; b < brick_count; ++b) {
+				if (!deleted[b] && rect_vs_ball(game_bricks[b].center, game_bricks[b].radius, false)) {
+					deleted[b] = 1;
+				}
+			}
+
+			for (uint32_t b = 0; b < 4; ++b) {
+				rect_vs_ball(L.blocks[b], L.block_radius, false);
+			}
+
+			game_bounces += ball_vs_bounds(L.extreme_radius, L.ball_radius, &ball, &velocity);
+		}
+
+		//----- extra balls -----
+		if (!state.starting_area && !state.ending_area) {
+			BallPool &balls = extra_balls[g];
+			if (balls.size() != extra_ball_count) {
+				spawn_extra_balls(&balls, rng[g], extra_ball_count, L.ball_radius.x, L.trail_length, L.base_court_radius);
+			}
+			std::vector< Rect > const &game_bricks = (state.flipped ? L.bricks_flipped : L.bricks);
+			uint8_t *deleted = (state.flipped ? brick_flipped_deleted.data() : brick_deleted.data()) + g * brick_count;
+			update_extra_balls(&balls, elapsed, main, [&](BallPool &pool) {
+				for (size_t b = 0; b < brick_count; ++b) {
+					if (!deleted[b] && pool.collide_rect(game_bricks[b].center, game_bricks[b].radius, false) != 0) {
+						deleted[b] = 1;
+					}
+				}
+			});
+		} else if (extra_balls[g].size() != 0) {
+			extra_balls[g].clear();
+		}
+
+		//----- POIs -----
+		for (auto const &poi : L.POIs) {
+			if (!poi_active(poi, state)) continue;
+
+			glm::vec2 displac = poi.center - ball;
+			float dist = std::sqrt(displac.x * displac.x + displac.y * displac.y);
+			if (dist > poi.radius) continue;
+
+			glm::vec2 displac_norm = displac / dist;
+			if (ball_enters_poi(poi, displac_norm, &ball, &velocity, &state)) continue;
+			ball = poi.center - displac_norm * poi.radius;
+			game_bounces += 1;
+		}
+
+		//store state back:
+		ball_x[g] = ball.x;
+		ball_y[g] = ball.y;
+		velocity_x[g] = velocity.x;
+		velocity_y[g] = velocity.y;
+		area[g] = (state.starting_area ? StartingArea : (state.ending_area ? EndingArea : MainArea));
+		flipped[g] = state.flipped ? 1 : 0;
+		rainbow[g] = state.rainbow ? 1 : 0;
+		bounces[g] = game_bounces;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "PongRules.hpp"
+#include "BallPool.hpp"
+#include "PCG32.hpp"
+
+#include <glm/glm.hpp>
+
+#include <new>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+/*
+ * PongBatch simulates many independent games of Pongoria at once, without a window,
+ *  for evaluating paddle controllers.
+ *
+ * Game state is stored structure-of-arrays (one vector per field, indexed by game),
+ *  and step() advances every game, partitioning the games across a pool of threads.
+ * Each thread only ever touches its own contiguous range of games, so no synchronization is
+ *  needed inside a step. The state arrays start on cache lines and ranges are split on 64-game
+ *  boundaries, so no two threads write to the same cache line of them.
+ *  (each game's extra balls, if any, are in that game's own BallPool allocations)
+ *
+ * The rules are the ones PongMode::update uses (PongRules.hpp), minus purely cosmetic parts
+ *  (trail, title, opacity, colors).
+ */
+
+//allocator that starts arrays on a cache line (so the partitioning above keeps threads apart):
+template< typename T >
+struct CacheLineAllocator {
+	typedef T value_type;
+	static constexpr size_t Align = 64;
+
+	CacheLineAllocator() = default;
+	template< typename U >
+	CacheLineAllocator(CacheLineAllocator< U > const &) { }
+
+	T *allocate(size_t n) {
+		//over-allocate, and keep what operator new returned just before the aligned block:
+		char *base = static_cast< char * >(::operator new(n * sizeof(T) + Align));
+		char *aligned = base + (Align - reinterpret_cast< uintptr_t >(base) % Align);
+		reinterpret_cast< char ** >(aligned)[-1] = base;
+		return reinterpret_cast< T * >(aligned);
+	}
+	void deallocate(T *p, size_t) {
+		::operator delete(reinterpret_cast< char ** >(p)[-1]);
+	}
+};
+template< typename T, typename U >
+bool operator==(CacheLineAllocator< T > const &, CacheLineAllocator< U > const &) { return true; }
+template< typename T, typename U >
+bool operator!=(CacheLineAllocator< T > const &, CacheLineAllocator< U > const &) { return false; }
+
+struct PongBatch {
+	//thread_count = 0 uses one thread per hardware core.
+	//extra_ball_count extra balls join each game in the main area (as with PongMode::extra_ball_count):
+	PongBatch(size_t count, uint32_t thread_count = 0, uint32_t extra_ball_count = 0);
+	~PongBatch();
+
+	PongBatch(PongBatch const &) = delete;
+	PongBatch &operator=(PongBatch const &) = delete;
+
+	//put game 'i' back at its starting state:
+	void reset(size_t i);
+
+	//advance all games by 'elapsed' seconds.
+	// actions[i] is the court-space position game i's paddles track
+	// (equivalent to PongMode's relative_mouse_pos):
+	void step(float elapsed, glm::vec2 const *actions);
+
+	size_t size() const { return ball_x.size(); }
+
+	//----- per-game state (SoA) -----
+	enum Area : uint8_t {
+		StartingArea = 0,
+		MainArea = 1,
+		EndingArea = 2,
+	};
+	template< typename T >
+	using Array = std::vector< T, CacheLineAllocator< T > >;
+	Array< float > ball_x, ball_y;
+	Array< float > velocity_x, velocity_y;
+	Array< uint8_t > area; //Area
+	Array< uint8_t > flipped;
+	Array< uint8_t > rainbow;
+	Array< uint32_t > bounces; //number of collisions so far (a cheap progress measure)
+
+	//brick state, 'brick_count' entries per game; bricks[g * brick_count + b]:
+	Array< uint8_t > brick_deleted;
+	Array< uint8_t > brick_flipped_deleted;
+
+	//extra balls (only while in the main area), and the generator that scatters them:
+	uint32_t extra_ball_count = 0;
+	Array< BallPool > extra_balls;
+	Array< PCG32 > rng;
+
+	//----- level layout (read-only after construction; copied out of a PongMode) -----
+	struct Rect {
+		glm::vec2 center;
+		glm::vec2 radius;
+	};
+	struct Circle : POIRule {
+		glm::vec2 center;
+		float radius;
+	};
+	struct Level {
+		std::vector< Rect > starting_walls, ending_walls;
+		glm::vec2 blocks[4]; //corner blocks: TR, BR, BL, TL
+		glm::vec2 block_radius;
+		std::vector< Rect > bricks, bricks_flipped;
+		std::vector< Circle > POIs;
+		glm::vec2 vert_paddle_radius, horiz_paddle_radius, ball_radius;
+		glm::vec2 ball_start, velocity_start;
+		glm::vec2 base_court_radius, extreme_radius;
+		float start_dist;
+		float trail_length; //(extra balls carry it, though PongBatch doesn't record trails)
+		glm::vec2 starting_paddle; //y is fixed; x tracks the action
+		glm::vec2 left_paddle, right_paddle, bottom_paddle, top_paddle; //fixed coordinate only
+		glm::vec2 left_far_paddle, right_far_paddle, bottom_far_paddle, top_far_paddle;
+	} level;
+	size_t brick_count = 0;
+
+	//----- thread pool -----
+	//advance games [begin,end):
+	void step_range(size_t begin, size_t end, float elapsed, glm::vec2 const *actions);
+	void worker_main(uint32_t partition);
+
+	uint32_t partitions = 1; //number of ranges games are split into (workers + calling thread)
+	size_t partition_begin(uint32_t partition) const;
+
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable work_cv; //signalled when a new step starts (or on shutdown)
+	std::condition_variable done_cv; //signalled when a worker finishes its range
+	uint64_t generation = 0; //incremented for every step
+	uint32_t working = 0; //workers still busy with the current step
+	bool quit = false;
+	float current_elapsed = 0.0f;
+	glm::vec2 const *current_actions = nullptr;
+};
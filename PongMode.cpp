@@ -1,24 +1,27 @@
 #include "PongMode.hpp"
 
+//for building texture mipmaps on the CPU:
+#include "MipChain.hpp"
+
 //for the GL_ERRORS() macro:
 #include "gl_errors.hpp"
 
 //for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 
-#include <random>
+//for checking that draw() doesn't allocate:
+#include "AllocationCounter.hpp"
+
+#include <cassert>
+
+constexpr float PongMode::CompactVertex::Units;
 
-PongMode::PongMode() {
+PongMode::PongMode(bool use_gl) {
 
-	//set up trail as if ball has been here for 'forever':
-	ball_trail.clear();
-	ball_trail.emplace_back(ball, trail_length);
-	ball_trail.emplace_back(ball, 0.0f);
+	restart_trail();
 
 	// initialize rand_colors
-	for (int i = 0; i < sizeof(rand_colors) / sizeof(rand_colors[0]); i++) {
-		rand_colors[i] = rand_color();
-	}
+	fill_rand_colors(rng, rand_colors, sizeof(rand_colors) / sizeof(rand_colors[0]));
 
 	// Set up POIs
 	POIs.emplace_back(glm::vec2(0.0f, 20.0f), POI_radius);
@@ -63,10 +66,21 @@ PongMode::PongMode() {
 	}
 
 	
+	if (!use_gl) return;
+
 	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
+	color_texture_program.reset(new ColorTextureProgram());
+	color_program.reset(new ColorProgram());
+	circle_program.reset(new CircleProgram());
+
+	{ //vertex buffers:
 		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
+		glGenBuffers(1, &compact_vertex_buffer);
+		glGenBuffers(1, &static_vertex_buffer);
+		glGenBuffers(1, &static_index_buffer);
+		glGenBuffers(1, &circle_vertex_buffer);
+		glGenBuffers(1, &index_buffer);
+		//for now, buffers will be un-filled.
 
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
@@ -81,37 +95,40 @@ PongMode::PongMode() {
 		//set vertex_buffer as the source of glVertexAttribPointer() commands:
 		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
 
+		//set index_buffer as the source of glDrawElements() indices (this binding is part of the vertex array object's state):
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
 		//set up the vertex array object to describe arrays of PongMode::Vertex:
 		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
+			color_texture_program->Position_vec4, //attribute
 			3, //size
 			GL_FLOAT, //type
 			GL_FALSE, //normalized
 			sizeof(Vertex), //stride
 			(GLbyte *)0 + 0 //offset
 		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
+		glEnableVertexAttribArray(color_texture_program->Position_vec4);
 		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
 
 		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
+			color_texture_program->Color_vec4, //attribute
 			4, //size
 			GL_UNSIGNED_BYTE, //type
 			GL_TRUE, //normalized
 			sizeof(Vertex), //stride
 			(GLbyte *)0 + 4*3 //offset
 		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
+		glEnableVertexAttribArray(color_texture_program->Color_vec4);
 
 		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
+			color_texture_program->TexCoord_vec2, //attribute
 			2, //size
 			GL_FLOAT, //type
 			GL_FALSE, //normalized
 			sizeof(Vertex), //stride
 			(GLbyte *)0 + 4*3 + 4*1 //offset
 		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+		glEnableVertexAttribArray(color_texture_program->TexCoord_vec2);
 
 		//done referring to vertex_buffer, so unbind it:
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -122,6 +139,71 @@ PongMode::PongMode() {
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
 
+	{ //vertex array mapping compact_vertex_buffer for color_program:
+		glGenVertexArrays(1, &compact_vertex_buffer_for_color_program);
+		glBindVertexArray(compact_vertex_buffer_for_color_program);
+		glBindBuffer(GL_ARRAY_BUFFER, compact_vertex_buffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+		//set up the vertex array object to describe arrays of PongMode::CompactVertex:
+		//(positions are not normalized: the shader gets fixed-point values, which OBJECT_TO_CLIP scales back down)
+		glVertexAttribPointer(color_program->Position_vec4, 2, GL_SHORT, GL_FALSE, sizeof(CompactVertex), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(color_program->Position_vec4);
+
+		glVertexAttribPointer(color_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CompactVertex), (GLbyte *)0 + 2*2);
+		glEnableVertexAttribArray(color_program->Color_vec4);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	}
+
+	{ //vertex array mapping static_vertex_buffer for color_program (same layout, different buffers):
+		glGenVertexArrays(1, &static_vertex_buffer_for_color_program);
+		glBindVertexArray(static_vertex_buffer_for_color_program);
+		glBindBuffer(GL_ARRAY_BUFFER, static_vertex_buffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, static_index_buffer);
+
+		glVertexAttribPointer(color_program->Position_vec4, 2, GL_SHORT, GL_FALSE, sizeof(CompactVertex), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(color_program->Position_vec4);
+
+		glVertexAttribPointer(color_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CompactVertex), (GLbyte *)0 + 2*2);
+		glEnableVertexAttribArray(color_program->Color_vec4);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	}
+
+	{ //vertex array mapping circle_vertex_buffer for circle_program:
+		glGenVertexArrays(1, &circle_vertex_buffer_for_circle_program);
+		glBindVertexArray(circle_vertex_buffer_for_circle_program);
+		glBindBuffer(GL_ARRAY_BUFFER, circle_vertex_buffer);
+		//(both vertex arrays draw from the same index buffer)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+		//set up the vertex array object to describe arrays of PongMode::CircleVertex:
+		glVertexAttribPointer(circle_program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(CircleVertex), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(circle_program->Position_vec4);
+
+		glVertexAttribPointer(circle_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CircleVertex), (GLbyte *)0 + 4*3);
+		glEnableVertexAttribArray(circle_program->Color_vec4);
+
+		glVertexAttribPointer(circle_program->Local_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(CircleVertex), (GLbyte *)0 + 4*3 + 4*1);
+		glEnableVertexAttribArray(circle_program->Local_vec2);
+
+		//(not normalized: the shader gets the byte values themselves, as floats)
+		glVertexAttribPointer(circle_program->Rings_vec2, 2, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(CircleVertex), (GLbyte *)0 + 4*3 + 4*1 + 4*2);
+		glEnableVertexAttribArray(circle_program->Rings_vec2);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	}
+
 	{ //solid white texture:
 		//ask OpenGL to fill white_tex with the name of an unused texture object:
 		glGenTextures(1, &white_tex);
@@ -129,21 +211,21 @@ PongMode::PongMode() {
 		//bind that texture object as a GL_TEXTURE_2D-type texture:
 		glBindTexture(GL_TEXTURE_2D, white_tex);
 
-		//upload a 1x1 image of solid white to the texture:
+		//upload a 1x1 image of solid white to the texture, along with its mipmaps:
+		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
+		//(the levels are built on the CPU by MipChain -- for textures loaded from files, use load_png_mips() or build_mip_chains()
+		// at load time, so the render thread only uploads)
 		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		MipChain mips(size, std::vector< glm::u8vec4 >(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff)));
+		mips.build();
+		mips.upload();
 
 		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
-
 		//Okay, texture uploaded, can unbind it:
 		glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -152,16 +234,37 @@ PongMode::PongMode() {
 }
 
 PongMode::~PongMode() {
+	if (!color_texture_program) return;
 
 	//----- free OpenGL resources -----
 	glDeleteBuffers(1, &vertex_buffer);
 	vertex_buffer = 0;
+	glDeleteBuffers(1, &compact_vertex_buffer);
+	compact_vertex_buffer = 0;
+	glDeleteBuffers(1, &static_vertex_buffer);
+	static_vertex_buffer = 0;
+	glDeleteBuffers(1, &static_index_buffer);
+	static_index_buffer = 0;
+	glDeleteBuffers(1, &circle_vertex_buffer);
+	circle_vertex_buffer = 0;
+	glDeleteBuffers(1, &index_buffer);
+	index_buffer = 0;
 
 	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
 	vertex_buffer_for_color_texture_program = 0;
+	glDeleteVertexArrays(1, &compact_vertex_buffer_for_color_program);
+	compact_vertex_buffer_for_color_program = 0;
+	glDeleteVertexArrays(1, &static_vertex_buffer_for_color_program);
+	static_vertex_buffer_for_color_program = 0;
+	glDeleteVertexArrays(1, &circle_vertex_buffer_for_circle_program);
+	circle_vertex_buffer_for_circle_program = 0;
 
 	glDeleteTextures(1, &white_tex);
 	white_tex = 0;
+	if (!atlas_textures.empty()) {
+		glDeleteTextures(GLsizei(atlas_textures.size()), atlas_textures.data());
+		atlas_textures.clear();
+	}
 }
 
 bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size, bool *QUIT) {
@@ -189,7 +292,11 @@ void PongMode::update_mouse_pos(glm::vec2 const& new_mouse_pos, glm::uvec2 const
 
 void PongMode::update(float elapsed, Window_settings& window_settings) {
 
-	static std::mt19937 mt; //mersenne twister pseudo-random number generator
+	//remember where things were, so draw() can interpolate from here:
+	ball_prev = ball;
+	camera_prev = camera_pos;
+	last_elapsed = elapsed;
+	trail_restarted = false;
 
 	// Update camera position based on camera velocity 
 	// TODO - implement list of camera targets, and default to ball as the target
@@ -204,47 +311,19 @@ void PongMode::update(float elapsed, Window_settings& window_settings) {
 	relative_mouse_pos = absolute_mouse_pos + camera_pos;
 
 	//----- paddle update -----
-	starting_paddle.x = relative_mouse_pos.x;
-
-	left_paddle.y = relative_mouse_pos.y;
-	right_paddle.y = relative_mouse_pos.y;
-	bottom_paddle.x = relative_mouse_pos.x;
-	top_paddle.x = relative_mouse_pos.x;
-
-	left_far_paddle.y = relative_mouse_pos.y;
-	right_far_paddle.y = relative_mouse_pos.y;
-	bottom_far_paddle.x = relative_mouse_pos.x;
-	top_far_paddle.x = relative_mouse_pos.x;
-
-	//clamp paddles to court:
-	starting_paddle.x = std::max(starting_paddle.x, -2.5f * start_dist + horiz_paddle_radius.x * 1.5f);
-	starting_paddle.x = std::min(starting_paddle.x, 2.5f * start_dist - horiz_paddle_radius.x * 1.5f);
-
-	// main paddles
-	left_paddle.y = std::max(left_paddle.y, -base_court_radius.y + vert_paddle_radius.y * 1.5f);
-	left_paddle.y = std::min(left_paddle.y, base_court_radius.y - vert_paddle_radius.y * 1.5f);
-
-	right_paddle.y = std::max(right_paddle.y, -base_court_radius.y + vert_paddle_radius.y * 1.5f);
-	right_paddle.y = std::min(right_paddle.y, base_court_radius.y - vert_paddle_radius.y * 1.5f);
+	//(clamped to their courts; see PongRules.hpp)
+	PaddlePlacement placement = place_paddles(relative_mouse_pos, start_dist, base_court_radius, extreme_radius, vert_paddle_radius, horiz_paddle_radius);
+	starting_paddle.x = placement.starting_x;
 
-	bottom_paddle.x = std::max(bottom_paddle.x, -base_court_radius.x + horiz_paddle_radius.x * 1.5f);
-	bottom_paddle.x = std::min(bottom_paddle.x, base_court_radius.x - horiz_paddle_radius.x * 1.5f);
+	left_paddle.y = placement.near_y;
+	right_paddle.y = placement.near_y;
+	bottom_paddle.x = placement.near_x;
+	top_paddle.x = placement.near_x;
 
-	top_paddle.x = std::max(top_paddle.x, -base_court_radius.x + horiz_paddle_radius.x * 1.5f);
-	top_paddle.x = std::min(top_paddle.x, base_court_radius.x - horiz_paddle_radius.x * 1.5f);
-
-	//far paddles
-	left_far_paddle.y = std::max(left_far_paddle.y, -extreme_radius.y + vert_paddle_radius.y * 1.5f);
-	left_far_paddle.y = std::min(left_far_paddle.y, extreme_radius.y - vert_paddle_radius.y * 1.5f);
-
-	right_far_paddle.y = std::max(right_far_paddle.y, -extreme_radius.y + vert_paddle_radius.y * 1.5f);
-	right_far_paddle.y = std::min(right_far_paddle.y, extreme_radius.y - vert_paddle_radius.y * 1.5f);
-
-	bottom_far_paddle.x = std::max(bottom_far_paddle.x, -extreme_radius.x + horiz_paddle_radius.x * 1.5f);
-	bottom_far_paddle.x = std::min(bottom_far_paddle.x, extreme_radius.x - horiz_paddle_radius.x * 1.5f);
-
-	top_far_paddle.x = std::max(top_far_paddle.x, -extreme_radius.x + horiz_paddle_radius.x * 1.5f);
-	top_far_paddle.x = std::min(top_far_paddle.x, extreme_radius.x - horiz_paddle_radius.x * 1.5f);
+	left_far_paddle.y = placement.far_y;
+	right_far_paddle.y = placement.far_y;
+	bottom_far_paddle.x = placement.far_x;
+	top_far_paddle.x = placement.far_x;
 
 	//----- ball update -----
 
@@ -260,101 +339,33 @@ void PongMode::update(float elapsed, Window_settings& window_settings) {
 
 	// lambda function to check for collisions with a rectangle
 	auto rect_vs_ball = [this,&window_settings](glm::vec2 const &rect, glm::vec2 const &radius, bool velo_warp) {
-		//compute area of overlap:
-		glm::vec2 min = glm::max(rect - radius, ball - ball_radius);
-		glm::vec2 max = glm::min(rect + radius, ball + ball_radius);
-
-		//if no overlap, no collision:
-		if (min.x > max.x || min.y > max.y) return false;
-
-		if (max.x - min.x > max.y - min.y) {
-			//wider overlap in x => bounce in y direction:
-			if (ball.y > rect.y) {
-				ball.y = rect.y + radius.y + ball_radius.y;
-				ball_velocity.y = std::abs(ball_velocity.y);
-			} else {
-				ball.y = rect.y - radius.y - ball_radius.y;
-				ball_velocity.y = -std::abs(ball_velocity.y);
-			}
-			//warp x velocity based on offset from paddle center:
-			if (velo_warp) {
-				float og_speed = sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
-				float vel = (ball.x - rect.x) / (radius.x + ball_radius.x);
-				ball_velocity.x = glm::mix(ball_velocity.x, vel, 0.75f);
-				ball_velocity /= sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
-				ball_velocity *= og_speed;
-			}
-		} else {
-			//wider overlap in y => bounce in x direction:
-			if (ball.x > rect.x) {
-				ball.x = rect.x + radius.x + ball_radius.x;
-				ball_velocity.x = std::abs(ball_velocity.x);
-			} else {
-				ball.x = rect.x - radius.x - ball_radius.x;
-				ball_velocity.x = -std::abs(ball_velocity.x);
-			}
-			//warp y velocity based on offset from paddle center:
-			if (velo_warp) {
-				float og_speed = sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
-				float vel = (ball.y - rect.y) / (radius.y + ball_radius.y);
-				ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
-				ball_velocity /= sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
-				ball_velocity *= og_speed;
-			}
-		}
-
+		if (!ball_vs_rect(rect, radius, velo_warp, ball_radius, &ball, &ball_velocity)) return false;
 		cycle_title(window_settings);
 		return true;
 	};
 
 	// lambda function to check for collisions with a circle
-	auto circle_vs_ball = [this, &window_settings](glm::vec2 const& circle, float radius, POI *poi) {
-		glm::vec2 displac = circle - ball;
+	auto circle_vs_ball = [this, &window_settings](POI const &poi) {
+		glm::vec2 displac = poi.Position - ball;
 		float dist = sqrt(displac.x * displac.x + displac.y * displac.y);
-		if (poi != NULL && dist <= radius + POI_opacity_radius_outer) {
-			window_settings.opacity = std::min(window_settings.opacity, (dist - (radius + POI_opacity_radius_inner)) / (POI_opacity_radius_outer - POI_opacity_radius_inner));
+		if (dist <= poi.Radius + POI_opacity_radius_outer) {
+			window_settings.opacity = std::min(window_settings.opacity, (dist - (poi.Radius + POI_opacity_radius_inner)) / (POI_opacity_radius_outer - POI_opacity_radius_inner));
 		}
-		if (dist > radius) {
+		if (dist > poi.Radius) {
 			return false;
 		}
-		// Update velocity
 		glm::vec2 displac_norm = displac / dist;
-		if (poi != NULL && poi->rainbow) {
-			state_rainbow = !state_rainbow;
-		}
-		if (poi != NULL && poi->flip) {
-			state_flipped = !state_flipped;
-			ball_velocity = -ball_velocity;
-			//set up trail as if ball has been here for 'forever':
-			ball_trail.clear();
-			ball_trail.emplace_back(ball, trail_length);
-			ball_trail.emplace_back(ball, 0.0f);
-		} else {
-			float dot_product = ball_velocity.x * displac_norm.x + ball_velocity.y * displac_norm.y;
-			glm::vec2 projection = dot_product * displac_norm;
-			ball_velocity -= projection * 2.0f;
-		}
-		if (poi != NULL && poi->starting) {
-			starting_area = false;
-			state_flipped = false;
-			ball = glm::vec2(0.0f, 0.0f);
-			//set up trail as if ball has been here for 'forever':
-			ball_trail.clear();
-			ball_trail.emplace_back(ball, trail_length);
-			ball_trail.emplace_back(ball, 0.0f);
+		AreaState state = area_state();
+		bool changed_area = ball_enters_poi(poi, displac_norm, &ball, &ball_velocity, &state);
+		set_area_state(state);
+		if (changed_area) {
+			restart_trail();
 			return true;
 		}
-		if (poi != NULL && poi->end_portal) {
-			ending_area = true;
-			state_flipped = false;
-			ball = glm::vec2(0.0f, 0.0f);
-			//set up trail as if ball has been here for 'forever':
-			ball_trail.clear();
-			ball_trail.emplace_back(ball, trail_length);
-			ball_trail.emplace_back(ball, 0.0f);
-			return true;
+		if (poi.flip) {
+			restart_trail();
 		}
-		ball = circle - displac_norm * radius;
+		ball = poi.Position - displac_norm * poi.Radius;
 		cycle_title(window_settings);
 		return true;
 	};
@@ -396,6 +407,7 @@ void PongMode::update(float elapsed, Window_settings& window_settings) {
 				if (!(*bricks_iter).deleted) {
 					if (rect_vs_ball((*bricks_iter).Position, (*bricks_iter).Radius, false)) {
 						(*bricks_iter).deleted = true;
+						invalidate_static_geometry();
 					}
 				}
 			}
@@ -405,6 +417,7 @@ void PongMode::update(float elapsed, Window_settings& window_settings) {
 				if (!(*bricks_iter).deleted) {
 					if (rect_vs_ball((*bricks_iter).Position, (*bricks_iter).Radius, false)) {
 						(*bricks_iter).deleted = true;
+						invalidate_static_geometry();
 					}
 				}
 			}
@@ -417,90 +430,99 @@ void PongMode::update(float elapsed, Window_settings& window_settings) {
 		rect_vs_ball(TL_block, block_radius, false);
 
 		//court extremeties:
-		if (ball.y > extreme_radius.y - ball_radius.y) {
-			ball.y = extreme_radius.y - ball_radius.y;
-			if (ball_velocity.y > 0.0f) {
-				ball_velocity.y = -ball_velocity.y;
-			}
-			//extend wall upward.
-			/*camera_bounds_max.y += d_camera_bounds_per_bounce;
-			camera_pos.y += d_camera_bounds_per_bounce * 0.5f;
-			window_settings.size.y += d_window_size_per_bounce;
-			window_settings.position.y -= d_window_size_per_bounce;*/
-			cycle_title(window_settings);
-		}
-		if (ball.y < -extreme_radius.y + ball_radius.y) {
-			ball.y = -extreme_radius.y + ball_radius.y;
-			if (ball_velocity.y < 0.0f) {
-				ball_velocity.y = -ball_velocity.y;
-			}
-			//extend wall downward.
-			/*camera_bounds_min.y -= d_camera_bounds_per_bounce;
-			camera_pos.y -= d_camera_bounds_per_bounce * 0.5f;
-			window_settings.size.y += d_window_size_per_bounce;*/
+		// (the court used to grow with each bounce here; see d_camera_bounds_per_bounce)
+		for (uint32_t bounces = ball_vs_bounds(extreme_radius, ball_radius, &ball, &ball_velocity); bounces > 0; --bounces) {
 			cycle_title(window_settings);
 		}
+	}
 
-		if (ball.x > extreme_radius.x - ball_radius.x) {
-			ball.x = extreme_radius.x - ball_radius.x;
-			if (ball_velocity.x > 0.0f) {
-				ball_velocity.x = -ball_velocity.x;
-			}
-			//extend wall right.
-			/*camera_bounds_max.x += d_camera_bounds_per_bounce;
-			camera_pos.x += d_camera_bounds_per_bounce * 0.5f;
-			window_settings.size.x += d_window_size_per_bounce;*/
-			cycle_title(window_settings);
-		}
-		if (ball.x < -extreme_radius.x + ball_radius.x) {
-			ball.x = -extreme_radius.x + ball_radius.x;
-			if (ball_velocity.x < 0.0f) {
-				ball_velocity.x = -ball_velocity.x;
-			}
-			//extend wall left.
-			/*camera_bounds_min.x -= d_camera_bounds_per_bounce;
-			camera_pos.x -= d_camera_bounds_per_bounce * 0.5f;
-			window_settings.size.x += d_window_size_per_bounce;
-			window_settings.position.x -= d_window_size_per_bounce;*/
-			cycle_title(window_settings);
-		}
+	//----- extra balls -----
+	//they only exist in the main area:
+	if (!starting_area && !ending_area) {
+		if (extra_balls.size() != extra_ball_count) spawn_extra_balls();
+		update_extra_balls(elapsed);
+	} else if (extra_balls.size() != 0) {
+		extra_balls.clear();
 	}
 
 	// Check POI collisions with ball
-	for (auto POI_iter = POIs.begin(); POI_iter != POIs.end(); POI_iter++) {
-		if ((POI_iter->starting && !starting_area) || (!POI_iter->starting && starting_area)) {
-			continue;
-		}
-		if (POI_iter->end_portal) {
-			if (starting_area || ending_area || !state_rainbow || state_flipped) {
-				continue;
-			}
-		}
-		circle_vs_ball((*POI_iter).Position, (*POI_iter).Radius, &(*POI_iter));
+	for (auto const &poi : POIs) {
+		if (!poi_active(poi, area_state())) continue;
+		circle_vs_ball(poi);
 	}
 
 
 	//----- rainbow trails -----
 
-	//age up all locations in ball trail:
-	for (auto &t : ball_trail) {
-		t.z += elapsed;
+	//store fresh location at back of ball trail (this also trims too-old locations):
+	trail_clock += elapsed;
+	ball_trail.push(ball, trail_clock);
+	extra_balls.record_trail(trail_clock);
+
+	//don't interpolate across teleports / flips:
+	if (trail_restarted) {
+		ball_prev = ball;
+		camera_prev = camera_pos;
 	}
-	//store fresh location at back of ball trail:
-	ball_trail.emplace_back(ball, 0.0f);
+}
+
+void PongMode::spawn_extra_balls() {
+	//scattered around the inner court, heading in random directions:
+	::spawn_extra_balls(&extra_balls, rng, extra_ball_count, ball_radius.x, trail_length, base_court_radius);
+}
 
-	//trim any too-old locations from back of trail:
-	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
-	while (ball_trail.size() >= 2 && ball_trail[1].z > trail_length) {
-		ball_trail.pop_front();
+void PongMode::update_extra_balls(float elapsed) {
+	MainAreaLayout layout;
+	glm::vec2 const *paddles[8] = {
+		&left_paddle, &right_paddle, &bottom_paddle, &top_paddle,
+		&left_far_paddle, &right_far_paddle, &bottom_far_paddle, &top_far_paddle,
+	};
+	for (uint32_t p = 0; p < 8; ++p) {
+		layout.paddles[p] = *paddles[p];
 	}
+	layout.vert_paddle_radius = vert_paddle_radius;
+	layout.horiz_paddle_radius = horiz_paddle_radius;
+	layout.blocks[0] = TR_block;
+	layout.blocks[1] = BR_block;
+	layout.blocks[2] = BL_block;
+	layout.blocks[3] = TL_block;
+	layout.block_radius = block_radius;
+	layout.extreme_radius = extreme_radius;
+
+	::update_extra_balls(&extra_balls, elapsed, layout, [this](BallPool &balls) {
+		for (auto &brick : (state_flipped ? bricks_flipped : bricks)) {
+			if (!brick.deleted && balls.collide_rect(brick.Position, brick.Radius, false) != 0) {
+				brick.deleted = true;
+				invalidate_static_geometry();
+			}
+		}
+	});
+}
+
+AreaState PongMode::area_state() const {
+	AreaState state;
+	state.starting_area = starting_area;
+	state.ending_area = ending_area;
+	state.flipped = state_flipped;
+	state.rainbow = state_rainbow;
+	return state;
+}
+
+void PongMode::set_area_state(AreaState const &state) {
+	starting_area = state.starting_area;
+	ending_area = state.ending_area;
+	state_flipped = state.flipped;
+	state_rainbow = state.rainbow;
+}
+
+void PongMode::restart_trail() {
+	ball_trail.restart(ball, trail_clock);
+	trail_restarted = true;
 }
 
 void PongMode::cycle_title(Mode::Window_settings &window_settings) {
 	//cycle rand_colors too
-	for (int i = 0; i < sizeof(rand_colors) / sizeof(rand_colors[0]); i++) {
-		rand_colors[i] = rand_color();
-	}
+	fill_rand_colors(rng, rand_colors, sizeof(rand_colors) / sizeof(rand_colors[0]));
 	//update window name
 	if (window_settings.title == NULL) {
 		window_settings.title = &title_cycle[0];
@@ -516,11 +538,301 @@ void PongMode::cycle_title(Mode::Window_settings &window_settings) {
 	window_settings.title = &title_cycle[0];
 }
 
-glm::u8vec4 PongMode::rand_color() {
-	return glm::u8vec4(glm::u8(rand()), glm::u8(rand()), glm::u8(rand()), 0xff);
+uint32_t PongMode::state_checksum() const {
+	//FNV-1a over the raw bytes of everything update() evolves:
+	uint32_t hash = 2166136261u;
+	auto mix_bytes = [&hash](void const *data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ reinterpret_cast< uint8_t const * >(data)[i]) * 16777619u;
+		}
+	};
+	mix_bytes(&ball, sizeof(ball));
+	mix_bytes(&ball_velocity, sizeof(ball_velocity));
+	mix_bytes(&camera_pos, sizeof(camera_pos));
+	bool flags[4] = { starting_area, ending_area, state_flipped, state_rainbow };
+	mix_bytes(flags, sizeof(flags));
+	for (auto const &brick : bricks) {
+		mix_bytes(&brick.deleted, sizeof(brick.deleted));
+	}
+	for (auto const &brick : bricks_flipped) {
+		mix_bytes(&brick.deleted, sizeof(brick.deleted));
+	}
+	mix_bytes(rand_colors, sizeof(rand_colors));
+	for (auto const *v : { &extra_balls.x, &extra_balls.y, &extra_balls.vx, &extra_balls.vy }) {
+		mix_bytes(v->data(), v->size() * sizeof(float));
+	}
+	return hash;
+}
+
+void PongMode::save_snapshot(Snapshot *snapshot) const {
+	assert(snapshot);
+	snapshot->ball = ball;
+	snapshot->ball_trail = ball_trail;
+	snapshot->trail_clock = trail_clock;
+	snapshot->extra_balls = extra_balls;
+	snapshot->camera_pos = camera_pos;
+	glm::vec2 const *paddles[9] = {
+		&starting_paddle,
+		&left_paddle, &right_paddle, &bottom_paddle, &top_paddle,
+		&left_far_paddle, &right_far_paddle, &bottom_far_paddle, &top_far_paddle,
+	};
+	for (uint32_t p = 0; p < 9; ++p) {
+		snapshot->paddles[p] = *paddles[p];
+	}
+	snapshot->bricks_deleted.resize(bricks.size());
+	for (size_t b = 0; b < bricks.size(); ++b) {
+		snapshot->bricks_deleted[b] = bricks[b].deleted;
+	}
+	snapshot->bricks_flipped_deleted.resize(bricks_flipped.size());
+	for (size_t b = 0; b < bricks_flipped.size(); ++b) {
+		snapshot->bricks_flipped_deleted[b] = bricks_flipped[b].deleted;
+	}
+	std::copy(rand_colors, rand_colors + sizeof(rand_colors) / sizeof(rand_colors[0]), snapshot->rand_colors);
+	snapshot->starting_area = starting_area;
+	snapshot->ending_area = ending_area;
+	snapshot->state_flipped = state_flipped;
+	snapshot->state_rainbow = state_rainbow;
+}
+
+void PongMode::load_snapshot(Snapshot const &prev, Snapshot const &next, float alpha) {
+	//don't interpolate across area changes or flips (the ball teleports / the trail restarts):
+	if (prev.starting_area != next.starting_area || prev.ending_area != next.ending_area || prev.state_flipped != next.state_flipped) {
+		alpha = 1.0f;
+	}
+	alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+	ball = glm::mix(prev.ball, next.ball, alpha);
+	//NOTE: trail is taken from 'next' as-is; its head may lead the drawn ball by up to one simulation step
+	ball_trail = next.ball_trail;
+	trail_clock = next.trail_clock;
+	//NOTE: extra balls aren't interpolated
+	extra_balls = next.extra_balls;
+	camera_pos = glm::mix(prev.camera_pos, next.camera_pos, alpha);
+	glm::vec2 *paddles[9] = {
+		&starting_paddle,
+		&left_paddle, &right_paddle, &bottom_paddle, &top_paddle,
+		&left_far_paddle, &right_far_paddle, &bottom_far_paddle, &top_far_paddle,
+	};
+	for (uint32_t p = 0; p < 9; ++p) {
+		*paddles[p] = glm::mix(prev.paddles[p], next.paddles[p], alpha);
+	}
+	bool bricks_changed = false;
+	assert(next.bricks_deleted.size() == bricks.size());
+	for (size_t b = 0; b < bricks.size(); ++b) {
+		bool deleted = (next.bricks_deleted[b] != 0);
+		bricks_changed = bricks_changed || (bricks[b].deleted != deleted);
+		bricks[b].deleted = deleted;
+	}
+	assert(next.bricks_flipped_deleted.size() == bricks_flipped.size());
+	for (size_t b = 0; b < bricks_flipped.size(); ++b) {
+		bool deleted = (next.bricks_flipped_deleted[b] != 0);
+		bricks_changed = bricks_changed || (bricks_flipped[b].deleted != deleted);
+		bricks_flipped[b].deleted = deleted;
+	}
+	if (bricks_changed) invalidate_static_geometry();
+	std::copy(next.rand_colors, next.rand_colors + sizeof(rand_colors) / sizeof(rand_colors[0]), rand_colors);
+	starting_area = next.starting_area;
+	ending_area = next.ending_area;
+	state_flipped = next.state_flipped;
+	state_rainbow = next.state_rainbow;
+	//already interpolated; draw as-is:
+	ball_prev = ball;
+	camera_prev = camera_pos;
+}
+
+glm::u8vec4 PongMode::rand_color(PCG32 &from) {
+	uint32_t bits = from();
+	return glm::u8vec4(glm::u8(bits), glm::u8(bits >> 8), glm::u8(bits >> 16), 0xff);
+}
+
+void PongMode::fill_rand_colors(PCG32 &from, glm::u8vec4 *colors, size_t count) {
+	//draw random bits in chunks, one 32-bit value per color (top byte replaced by an opaque alpha):
+	uint32_t bits[16];
+	for (size_t begin = 0; begin < count; begin += 16) {
+		size_t chunk = std::min< size_t >(16, count - begin);
+		from.fill(bits, chunk);
+		for (size_t i = 0; i < chunk; ++i) {
+			colors[begin + i] = glm::u8vec4(glm::u8(bits[i]), glm::u8(bits[i] >> 8), glm::u8(bits[i] >> 16), 0xff);
+		}
+	}
+}
+
+void PongMode::draw(glm::uvec2 const &drawable_size, float alpha) {
+	assert(color_texture_program && "PongMode::draw() called on a mode constructed without OpenGL");
+
+	DrawList list(frame_arena);
+	build_draw_list(drawable_size, alpha, &list);
+
+	//---- actual drawing ----
+
+	//clear the color buffer:
+	glClearColor(list.bg_color.r / 255.0f, list.bg_color.g / 255.0f, list.bg_color.b / 255.0f, list.bg_color.a / 255.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	//use alpha blending:
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	//don't use the depth test:
+	glDisable(GL_DEPTH_TEST);
+
+	//upload vertices to vertex_buffer, compact_vertex_buffer, and circle_vertex_buffer:
+	if (!list.vertices.empty()) {
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
+		glBufferData(GL_ARRAY_BUFFER, list.vertices.size() * sizeof(list.vertices[0]), list.vertices.data(), GL_STREAM_DRAW); //upload vertices array
+	}
+	if (!list.compact_vertices.empty()) {
+		glBindBuffer(GL_ARRAY_BUFFER, compact_vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, list.compact_vertices.size() * sizeof(list.compact_vertices[0]), list.compact_vertices.data(), GL_STREAM_DRAW);
+	}
+	if (!list.circle_vertices.empty()) {
+		glBindBuffer(GL_ARRAY_BUFFER, circle_vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, list.circle_vertices.size() * sizeof(list.circle_vertices[0]), list.circle_vertices.data(), GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//upload indices to index_buffer, as 16-bit values if every vertex can be reached that way:
+	GLenum index_type = GL_UNSIGNED_INT;
+	size_t index_size = sizeof(uint32_t);
+	ArenaVector< uint16_t > short_indices(frame_arena);
+	void const *index_data = list.indices.data();
+	if (std::max(std::max(list.vertices.size(), list.compact_vertices.size()), list.circle_vertices.size()) <= 0x10000) {
+		short_indices.reserve(list.indices.size());
+		for (uint32_t index : list.indices) {
+			short_indices.emplace_back(uint16_t(index));
+		}
+		index_type = GL_UNSIGNED_SHORT;
+		index_size = sizeof(uint16_t);
+		index_data = short_indices.data();
+	}
+	//(element array bindings belong to the vertex array object, so bind one to upload through)
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, list.indices.size() * index_size, index_data, GL_STREAM_DRAW);
+	glBindVertexArray(0);
+
+	//upload static geometry, if it was rebuilt since last time:
+	if (list.static_geometry && list.static_geometry->revision != static_revision_uploaded) {
+		StaticGeometry const &geometry = *list.static_geometry;
+		glBindBuffer(GL_ARRAY_BUFFER, static_vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, geometry.vertices.size() * sizeof(geometry.vertices[0]), geometry.vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		ArenaVector< uint16_t > short_static_indices(frame_arena);
+		void const *static_index_data = geometry.indices.data();
+		size_t static_index_size = sizeof(uint32_t);
+		static_index_type = GL_UNSIGNED_INT;
+		if (geometry.vertices.size() <= 0x10000) {
+			short_static_indices.reserve(geometry.indices.size());
+			for (uint32_t index : geometry.indices) {
+				short_static_indices.emplace_back(uint16_t(index));
+			}
+			static_index_data = short_static_indices.data();
+			static_index_size = sizeof(uint16_t);
+			static_index_type = GL_UNSIGNED_SHORT;
+		}
+		glBindVertexArray(static_vertex_buffer_for_color_program);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indices.size() * static_index_size, static_index_data, GL_STATIC_DRAW);
+		glBindVertexArray(0);
+
+		static_revision_uploaded = geometry.revision;
+	}
+
+	//upload atlas pages, if the atlas was re-packed since last time:
+	if (list.atlas && list.atlas->revision != atlas_revision_uploaded) {
+		TextureAtlas const &atlas = *list.atlas;
+		while (atlas_textures.size() < atlas.pages.size()) {
+			atlas_textures.emplace_back(0);
+			glGenTextures(1, &atlas_textures.back());
+		}
+		for (uint32_t i = 0; i < atlas.pages.size(); ++i) {
+			glBindTexture(GL_TEXTURE_2D, atlas_textures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlas.page_size.x, atlas.page_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas.pages[i].data());
+			//(no mipmaps: sprites are padded by a pixel, which is enough for bilinear filtering but not for smaller mip levels)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		atlas_revision_uploaded = atlas.revision;
+	}
+
+	//upload per-frame uniforms to each program:
+	glUseProgram(color_texture_program->program);
+	glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(list.world_to_clip));
+	glUseProgram(color_program->program);
+	glUniformMatrix4fv(color_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(list.compact_to_clip));
+	glUseProgram(circle_program->program);
+	glUniformMatrix4fv(circle_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(list.world_to_clip));
+	if (list.ring_count != 0) {
+		glUniform4fv(circle_program->RING_COLORS_vec4_array, GLsizei(list.ring_count), glm::value_ptr(list.ring_colors[0]));
+		glUniform1fv(circle_program->RING_RADII_float_array, GLsizei(list.ring_count), list.ring_radii);
+	}
+
+	//bind the solid white texture to location zero so things will be drawn just with their colors:
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, white_tex);
+	GLuint bound_texture = white_tex;
+
+	//run the OpenGL pipeline, switching programs between runs of each kind of vertex:
+	for (auto const &batch : list.batches) {
+		if (batch.kind == DrawList::Batch::Triangles || batch.kind == DrawList::Batch::Sprites) {
+			glUseProgram(color_texture_program->program);
+			glBindVertexArray(vertex_buffer_for_color_texture_program);
+			//sprites use their atlas page, everything else the solid white texture:
+			GLuint texture = (batch.kind == DrawList::Batch::Sprites ? atlas_textures[batch.page] : white_tex);
+			if (texture != bound_texture) {
+				glBindTexture(GL_TEXTURE_2D, texture);
+				bound_texture = texture;
+			}
+		} else if (batch.kind == DrawList::Batch::CompactTriangles) {
+			glUseProgram(color_program->program);
+			glBindVertexArray(compact_vertex_buffer_for_color_program);
+		} else if (batch.kind == DrawList::Batch::Static) {
+			glUseProgram(color_program->program);
+			glBindVertexArray(static_vertex_buffer_for_color_program);
+			size_t static_index_size = (static_index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+			glDrawElements(GL_TRIANGLES, GLsizei(batch.count), static_index_type, (GLbyte *)0 + batch.first * static_index_size);
+			continue;
+		} else {
+			glUseProgram(circle_program->program);
+			glBindVertexArray(circle_vertex_buffer_for_circle_program);
+		}
+		glDrawElements(GL_TRIANGLES, GLsizei(batch.count), index_type, (GLbyte *)0 + batch.first * index_size);
+	}
+
+	//unbind the texture:
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//reset vertex array to none:
+	glBindVertexArray(0);
+
+	//reset current program to none:
+	glUseProgram(0);
+	
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+
 }
 
-void PongMode::draw(glm::uvec2 const &drawable_size) {
+void PongMode::build_draw_list(glm::uvec2 const &drawable_size, float alpha, DrawList *list) {
+	assert(list);
+
+	//scratch containers below live in frame_arena; building the frame shouldn't touch the heap
+	// (except when the arena itself has to grow):
+	uint64_t allocations_before = heap_allocation_count();
+	uint64_t arena_blocks_before = frame_arena.heap_blocks;
+
+	//draw moving things 'alpha' of the way from their state before the last update to their current state:
+	// (alpha >= 1 uses the current state exactly)
+	auto interpolate = [alpha](glm::vec2 const &prev, glm::vec2 const &current) {
+		return (alpha >= 1.0f ? current : glm::mix(prev, current, glm::max(alpha, 0.0f)));
+	};
+	glm::vec2 ball_at = interpolate(ball_prev, ball);
+	glm::vec2 camera_at = interpolate(camera_prev, camera_pos);
+	//the drawn ball is this much older than the newest trail point:
+	float trail_offset = (alpha >= 1.0f ? 0.0f : (1.0f - glm::max(alpha, 0.0f)) * last_elapsed);
+
 	//some nice colors from the course web page:
 	#define HEX_TO_U8VEC4( HX ) (state_flipped ? (~glm::u8vec4(HX >> 24, HX >> 16, HX >> 8, ~HX)) : (glm::u8vec4(HX >> 24, HX >> 16, HX >> 8, HX)) )
 	const glm::u8vec4 bg_color = ending_area ? HEX_TO_U8VEC4(0xffffffff) : (state_rainbow ? (rand_colors[0]) : HEX_TO_U8VEC4(0x76BED0ff));
@@ -534,7 +846,8 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	const glm::u8vec4 mauve_color = HEX_TO_U8VEC4(0x8B687Fff);
 	const glm::u8vec4 gold_color = HEX_TO_U8VEC4(0xd1bf1bff);
 	const glm::u8vec4 red_color = HEX_TO_U8VEC4(0x8f071bff);
-	std::vector< glm::u8vec4 > rainbow_colors = {};
+	ArenaVector< glm::u8vec4 > rainbow_colors(frame_arena);
+	rainbow_colors.reserve(21);
 	for (int i = 0; i < 21; i++) {
 		glm::u8vec4 faded_color = shadow_color;
 		faded_color.a -= i * (0xff / 21);
@@ -550,86 +863,283 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	const float shadow_offset = 0.07f;
 	const float padding = 0.14f; //padding between outside of walls and edge of window
 
+	//------ compute court-to-window transform ------
+
+	//compute area that should be visible:
+	glm::vec2 scene_min = glm::vec2(
+		/*-court_radius.x - 2.0f * wall_radius - padding,
+		-court_radius.y - 2.0f * wall_radius - padding*/
+		camera_bounds_min.x,
+		camera_bounds_min.y
+	);
+	glm::vec2 scene_max = glm::vec2(
+		/*court_radius.x + 2.0f * wall_radius + padding,
+		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding*/
+		camera_bounds_max.x,
+		camera_bounds_max.y
+	);
+
+	//compute window aspect ratio:
+	float aspect = drawable_size.x / float(drawable_size.y);
+	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
+
+	//compute scale factor for court given that...
+	float scale = std::min(
+		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
+		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
+	);
+
+	if (state_flipped) {
+		scale = -scale;
+	}
+
+	glm::vec2 center = 0.5f * (scene_max + scene_min);
+
+	//build matrix that scales and translates appropriately:
+	// (vertices are in world space, so this includes moving the camera to the origin)
+	glm::vec2 world_center = camera_at + center;
+	glm::mat4 world_to_clip = glm::mat4(
+		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, scale, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-world_center.x * (scale / aspect), -world_center.y * scale, 0.0f, 1.0f)
+	);
+	//NOTE: glm matrices are specified in *Column-Major* order,
+	// so each line above is specifying a *column* of the matrix(!)
+
+	//same, for fixed-point CompactVertex positions:
+	glm::mat4 compact_to_clip = world_to_clip * glm::mat4(
+		glm::vec4(1.0f / CompactVertex::Units, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 1.0f / CompactVertex::Units, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+	);
+
+	//also build the matrix that takes clip coordinates to (camera-relative) court coordinates (used for mouse handling):
+	clip_to_court = glm::mat3x2(
+		glm::vec2(aspect / scale, 0.0f),
+		glm::vec2(0.0f, 1.0f / scale),
+		glm::vec2(center.x, center.y)
+	);
+
+	//court-space rectangle visible through the window (clip space [-1,1]x[-1,1] mapped back through clip_to_court):
+	//NOTE: scale is negative when flipped, but the visible area is symmetric about center so only its magnitude matters
+	glm::vec2 visible_radius = glm::vec2(aspect, 1.0f) / std::abs(scale);
+	glm::vec2 visible_min = camera_at + center - visible_radius;
+	glm::vec2 visible_max = camera_at + center + visible_radius;
+	//size of one pixel in court units:
+	float pixel_size = 2.0f / (std::abs(scale) * drawable_size.y);
+
+	//helper to skip primitives that lie entirely outside the visible area:
+	auto is_visible = [&visible_min, &visible_max](glm::vec2 const &center, glm::vec2 const &radius) {
+		return center.x + radius.x >= visible_min.x && center.x - radius.x <= visible_max.x
+		    && center.y + radius.y >= visible_min.y && center.y - radius.y <= visible_max.y;
+	};
+
 	//---- compute vertices to draw ----
 
 	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices; // Triangle vertices
+	ArenaVector< Vertex > &vertices = list->vertices; // Triangle vertices (if they don't fit in compact_vertices)
+	ArenaVector< CompactVertex > &compact_vertices = list->compact_vertices; // Triangle vertices
+	ArenaVector< CircleVertex > &circle_vertices = list->circle_vertices; // Circle quad vertices
+	ArenaVector< uint32_t > &indices = list->indices; // Triangles, as indices into one of the above
+	//(reserve about what was needed last frame, plus some slack, so the vectors don't regrow)
+	vertices.reserve(vertex_count_hint);
+	compact_vertices.reserve(compact_vertex_count_hint);
+	circle_vertices.reserve(circle_vertex_count_hint);
+	indices.reserve(index_count_hint);
+	list->batches.reserve(16);
+
+	//call before adding triangles of a given kind, to keep the list of batches in drawing order:
+	// (batch counts are filled in at the end)
+	auto start_batch = [list](DrawList::Batch::Kind kind) {
+		if (!list->batches.empty() && list->batches.back().kind == kind) return;
+		list->batches.emplace_back(DrawList::Batch{kind, uint32_t(list->indices.size()), 0});
+	};
+
+	//two CCW-oriented triangles from the four vertices starting at 'base' (going counterclockwise):
+	auto add_quad_indices = [&indices](uint32_t base) {
+		indices.emplace_back(base + 0);
+		indices.emplace_back(base + 1);
+		indices.emplace_back(base + 2);
+
+		indices.emplace_back(base + 0);
+		indices.emplace_back(base + 2);
+		indices.emplace_back(base + 3);
+	};
+
+	//untextured triangles go in compact_vertices if their positions fit CompactVertex's fixed-point range
+	// (everything on the court does), and in vertices otherwise.
+	//call before adding untextured vertices within 'radius' of 'at'; returns true if they should be compact:
+	const float compact_limit = 32767.0f / CompactVertex::Units;
+	auto start_untextured = [&start_batch, compact_limit](glm::vec2 const &at, glm::vec2 const &radius) {
+		glm::vec2 farthest = glm::abs(at) + glm::abs(radius);
+		bool compact = (farthest.x <= compact_limit && farthest.y <= compact_limit);
+		start_batch(compact ? DrawList::Batch::CompactTriangles : DrawList::Batch::Triangles);
+		return compact;
+	};
+	//index of the next untextured vertex:
+	auto next_untextured = [&vertices, &compact_vertices](bool compact) {
+		return uint32_t(compact ? compact_vertices.size() : vertices.size());
+	};
+	auto add_untextured = [&vertices, &compact_vertices](bool compact, glm::vec2 const &at, glm::u8vec4 const &color) {
+		if (compact) compact_vertices.emplace_back(at, color);
+		else vertices.emplace_back(glm::vec3(at, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	};
 
 	//inline helper function for rectangle drawing:
-	auto draw_rectangle = [&vertices,this](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x - camera_pos.x, center.y-radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x - camera_pos.x, center.y-radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x - camera_pos.x, center.y+radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x - camera_pos.x, center.y-radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x - camera_pos.x, center.y+radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x - camera_pos.x, center.y+radius.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	auto draw_rectangle = [&is_visible,&start_untextured,&next_untextured,&add_untextured,&add_quad_indices](glm::vec2 const &at, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		//cull rectangles that can't be seen:
+		if (!is_visible(at, radius)) return;
+		bool compact = start_untextured(at, radius);
+
+		//draw rectangle as two CCW-oriented triangles sharing a diagonal:
+		add_quad_indices(next_untextured(compact));
+		add_untextured(compact, glm::vec2(at.x-radius.x, at.y-radius.y), color);
+		add_untextured(compact, glm::vec2(at.x+radius.x, at.y-radius.y), color);
+		add_untextured(compact, glm::vec2(at.x+radius.x, at.y+radius.y), color);
+		add_untextured(compact, glm::vec2(at.x-radius.x, at.y+radius.y), color);
 	};
 	
+	//inline helper function for drawing a circle (or set of rings, if 'rings' has a non-zero count) as one quad:
+	auto draw_circle_quad = [&circle_vertices, &start_batch, &add_quad_indices, pixel_size](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color, glm::u8vec2 const &rings) {
+		start_batch(DrawList::Batch::Circles);
+		//quad extends a pixel past the edge, to leave room for anti-aliasing:
+		glm::vec2 extent = radius + glm::vec2(pixel_size);
+		glm::vec2 local = extent / radius;
+		glm::vec3 at = glm::vec3(center, 0.0f);
+		add_quad_indices(uint32_t(circle_vertices.size()));
+		circle_vertices.emplace_back(at + glm::vec3(-extent.x, -extent.y, 0.0f), color, glm::vec2(-local.x, -local.y), rings);
+		circle_vertices.emplace_back(at + glm::vec3( extent.x, -extent.y, 0.0f), color, glm::vec2( local.x, -local.y), rings);
+		circle_vertices.emplace_back(at + glm::vec3( extent.x,  extent.y, 0.0f), color, glm::vec2( local.x,  local.y), rings);
+		circle_vertices.emplace_back(at + glm::vec3(-extent.x,  extent.y, 0.0f), color, glm::vec2(-local.x,  local.y), rings);
+	};
+
 	//inline helper function for circle drawing:
-	auto draw_filled_circle = [&vertices, this](glm::vec2 const& center, glm::vec2 const& radius, glm::u8vec4 const& color, bool rand_num_points = false) {
-		uint16_t points = 100;
-		if (rand_num_points) {
-			points = rand() % 10 + 3;
+	// (rand_num_points draws a random 3-12 sided polygon instead, which still needs actual triangles)
+	auto draw_filled_circle = [&indices, &is_visible, &start_untextured, &next_untextured, &add_untextured, &draw_circle_quad, this](glm::vec2 const& center, glm::vec2 const& radius, glm::u8vec4 const& color, bool rand_num_points = false) {
+		//cull circles whose bounding box can't be seen:
+		if (!is_visible(center, radius)) return;
+
+		if (!rand_num_points) {
+			draw_circle_quad(center, radius, color, glm::u8vec2(0, 0));
+			return;
 		}
-		float radians1 = 0;
-		float x1 = cos(radians1);
-		float y1 = sin(radians1);
-		float radians0, x0, y0;
-		for (uint16_t i = 1; i <= points + 1; i++) {
-			radians0 = radians1;
-			x0 = x1;
-			y0 = y1;
-			radians1 = i / float(points + 1) * 2.0f * float(M_PI);
-			x1 = cos(radians1);
-			y1 = sin(radians1);
-			vertices.emplace_back(glm::vec3(center.x - camera_pos.x, center.y - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-			vertices.emplace_back(glm::vec3(center.x + radius.x * x0 - camera_pos.x, center.y + radius.y * y0 - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-			vertices.emplace_back(glm::vec3(center.x + radius.x * x1 - camera_pos.x, center.y + radius.y * y1 - camera_pos.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+
+		glm::vec2 const &at = center;
+		bool compact = start_untextured(at, radius);
+		uint16_t points = draw_rng.below(10) + 3;
+		//a fan of triangles around a shared center vertex, with each rim vertex shared by two triangles:
+		uint32_t base = next_untextured(compact);
+		uint32_t sides = points + 1;
+		add_untextured(compact, at, color);
+		for (uint32_t i = 0; i < sides; i++) {
+			float radians = i / float(sides) * 2.0f * float(M_PI);
+			float x = cos(radians);
+			float y = sin(radians);
+			add_untextured(compact, glm::vec2(at.x + radius.x * x, at.y + radius.y * y), color);
+
+			indices.emplace_back(base);
+			indices.emplace_back(base + 1 + i);
+			indices.emplace_back(base + 1 + (i + 1) % sides);
 		}
-		//should use triangle fan instead?
 	};
 
 	
-	if (starting_area) { // ----- STARTING AREA -----
-		draw_rectangle(starting_paddle, horiz_paddle_radius, paddle_color);
-
-		draw_rectangle(left_wall, left_wall_rad, paddle_color);
-		draw_rectangle(right_wall, right_wall_rad, paddle_color);
-		draw_rectangle(bottom_wall, bottom_wall_rad, paddle_color);
-		draw_rectangle(top_wall, top_wall_rad, paddle_color);
-
-		draw_rectangle(BL_wall, BL_wall_rad, paddle_color);
-		draw_rectangle(BR_wall, BR_wall_rad, paddle_color);
-		draw_rectangle(TR_wall, TR_wall_rad, paddle_color);
+	//---- static geometry ----
+	//walls, corner blocks, and bricks only change with game state, so their (world-space) triangles are kept
+	// in static_geometry between frames, and only rebuilt (and re-uploaded by draw()) when something changes:
+	const glm::u8vec4 wall_color = (ending_area ? black_always_color : paddle_color);
+	uint64_t static_allocations = 0; //(rebuilding may grow static_geometry's vectors)
+	if (static_geometry.generation != static_geometry_generation
+	 || static_geometry.starting_area != starting_area || static_geometry.ending_area != ending_area || static_geometry.state_flipped != state_flipped
+	 || static_geometry.wall_color != wall_color || static_geometry.brick_color != brick_color) {
+		uint64_t static_allocations_before = heap_allocation_count();
+
+		StaticGeometry &geometry = static_geometry;
+		geometry.vertices.clear();
+		geometry.indices.clear();
+		auto add_rectangle = [&geometry, compact_limit](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+			assert(std::abs(center.x) + std::abs(radius.x) <= compact_limit && std::abs(center.y) + std::abs(radius.y) <= compact_limit && "static geometry should fit in CompactVertex");
+			(void)compact_limit; //(unused when NDEBUG is defined)
+			uint32_t base = uint32_t(geometry.vertices.size());
+			geometry.vertices.emplace_back(glm::vec2(center.x-radius.x, center.y-radius.y), color);
+			geometry.vertices.emplace_back(glm::vec2(center.x+radius.x, center.y-radius.y), color);
+			geometry.vertices.emplace_back(glm::vec2(center.x+radius.x, center.y+radius.y), color);
+			geometry.vertices.emplace_back(glm::vec2(center.x-radius.x, center.y+radius.y), color);
+			for (uint32_t i : {0, 1, 2, 0, 2, 3}) {
+				geometry.indices.emplace_back(base + i);
+			}
+		};
+
+		if (starting_area) { // ----- STARTING AREA -----
+			add_rectangle(left_wall, left_wall_rad, wall_color);
+			add_rectangle(right_wall, right_wall_rad, wall_color);
+			add_rectangle(bottom_wall, bottom_wall_rad, wall_color);
+			add_rectangle(top_wall, top_wall_rad, wall_color);
+
+			add_rectangle(BL_wall, BL_wall_rad, wall_color);
+			add_rectangle(BR_wall, BR_wall_rad, wall_color);
+			add_rectangle(TR_wall, TR_wall_rad, wall_color);
+
+		} else if (ending_area) { // ----- ENDING AREA -----
+			add_rectangle(left_end_wall, left_end_wall_rad, wall_color);
+			add_rectangle(right_end_wall, right_end_wall_rad, wall_color);
+			add_rectangle(bottom_end_wall, bottom_end_wall_rad, wall_color);
+			add_rectangle(top_end_wall, top_end_wall_rad, wall_color);
+
+			// Final Triangle
+			// (the camera stays at the origin in the ending area, so this is also where it always appeared on screen)
+			uint32_t base = uint32_t(geometry.vertices.size());
+			geometry.vertices.emplace_back(glm::vec2(0.0f, -2.0f), wall_color);
+			geometry.vertices.emplace_back(glm::vec2(4.0f, 2.0f), wall_color);
+			geometry.vertices.emplace_back(glm::vec2(-4.0f, 2.0f), wall_color);
+			for (uint32_t i = 0; i < 3; ++i) {
+				geometry.indices.emplace_back(base + i);
+			}
 
+		} else { // ----- MAIN AREA -----
+			//walls:
+			add_rectangle(glm::vec2(-extreme_radius.x - wall_radius, 0.0f), glm::vec2(wall_radius, extreme_radius.y + 2.0f * wall_radius), wall_color);
+			add_rectangle(glm::vec2(extreme_radius.x + wall_radius, 0.0f), glm::vec2(wall_radius, extreme_radius.y + 2.0f * wall_radius), wall_color);
+			add_rectangle(glm::vec2(0.0f, -extreme_radius.y - wall_radius), glm::vec2(extreme_radius.x, wall_radius), wall_color);
+			add_rectangle(glm::vec2(0.0f, extreme_radius.y + wall_radius), glm::vec2(extreme_radius.x, wall_radius), wall_color);
+
+			// Corner blocks:
+			add_rectangle(TR_block, block_radius, wall_color);
+			add_rectangle(BR_block, block_radius, wall_color);
+			add_rectangle(BL_block, block_radius, wall_color);
+			add_rectangle(TL_block, block_radius, wall_color);
+
+			//bricks:
+			for (auto const &brick : (state_flipped ? bricks_flipped : bricks)) {
+				if (!brick.deleted) {
+					add_rectangle(brick.Position, brick.Radius, brick_color);
+				}
+			}
+		}
 
-	} else if (ending_area) { // ----- ENDING AREA -----
-		draw_rectangle(left_end_wall, left_end_wall_rad, black_always_color);
-		draw_rectangle(right_end_wall, right_end_wall_rad, black_always_color);
-		draw_rectangle(bottom_end_wall, bottom_end_wall_rad, black_always_color);
-		draw_rectangle(top_end_wall, top_end_wall_rad, black_always_color);
+		geometry.generation = static_geometry_generation;
+		geometry.starting_area = starting_area;
+		geometry.ending_area = ending_area;
+		geometry.state_flipped = state_flipped;
+		geometry.wall_color = wall_color;
+		geometry.brick_color = brick_color;
+		geometry.revision += 1;
 
-		// Final Triangle
-		vertices.emplace_back(glm::vec3(0.0f, -2.0f, 0.0f), black_always_color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(4.0f, 2.0f, 0.0f), black_always_color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(-4.0f, 2.0f, 0.0f), black_always_color, glm::vec2(0.5f, 0.5f));
+		static_allocations = heap_allocation_count() - static_allocations_before;
+	}
+	list->static_geometry = &static_geometry;
+	if (!static_geometry.indices.empty()) {
+		list->batches.emplace_back(DrawList::Batch{DrawList::Batch::Static, 0, uint32_t(static_geometry.indices.size())});
+	}
 
-	} else { // ----- MAIN AREA -----
-		//walls:
-		draw_rectangle(glm::vec2(-extreme_radius.x - wall_radius, 0.0f), glm::vec2(wall_radius, extreme_radius.y + 2.0f * wall_radius), paddle_color);
-		draw_rectangle(glm::vec2(extreme_radius.x + wall_radius, 0.0f), glm::vec2(wall_radius, extreme_radius.y + 2.0f * wall_radius), paddle_color);
-		draw_rectangle(glm::vec2(0.0f, -extreme_radius.y - wall_radius), glm::vec2(extreme_radius.x, wall_radius), paddle_color);
-		draw_rectangle(glm::vec2(0.0f, extreme_radius.y + wall_radius), glm::vec2(extreme_radius.x, wall_radius), paddle_color);
-
-		// Corner blocks:
-		draw_rectangle(TR_block, block_radius, paddle_color);
-		draw_rectangle(BR_block, block_radius, paddle_color);
-		draw_rectangle(BL_block, block_radius, paddle_color);
-		draw_rectangle(TL_block, block_radius, paddle_color);
+	//---- dynamic geometry ----
 
-		//paddles:
+	//paddles:
+	if (starting_area) {
+		draw_rectangle(starting_paddle, horiz_paddle_radius, paddle_color);
+	} else if (!ending_area) {
 		draw_rectangle(left_paddle, vert_paddle_radius, paddle_color);
 		draw_rectangle(right_paddle, vert_paddle_radius, paddle_color);
 		draw_rectangle(bottom_paddle, horiz_paddle_radius, paddle_color);
@@ -639,44 +1149,44 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 		draw_rectangle(right_far_paddle, vert_paddle_radius, paddle_color);
 		draw_rectangle(bottom_far_paddle, horiz_paddle_radius, paddle_color);
 		draw_rectangle(top_far_paddle, horiz_paddle_radius, paddle_color);
-
-		//bricks:
-		if (state_flipped) {
-			for (auto bricks_iter = bricks_flipped.begin(); bricks_iter != bricks_flipped.end(); bricks_iter++) {
-				if (!(*bricks_iter).deleted) {
-					draw_rectangle((*bricks_iter).Position, (*bricks_iter).Radius, brick_color);
-				}
-			}
-		} else {
-			for (auto bricks_iter = bricks.begin(); bricks_iter != bricks.end(); bricks_iter++) {
-				if (!(*bricks_iter).deleted) {
-					draw_rectangle((*bricks_iter).Position, (*bricks_iter).Radius, brick_color);
-				}
-			}
-		}
 	}
 
 	// POIs
 	for (auto POI_iter = POIs.begin(); POI_iter != POIs.end(); POI_iter++) {
-		if ((POI_iter->starting && !starting_area) || (!POI_iter->starting && starting_area)) {
+		if (!poi_active(*POI_iter, area_state())) {
 			continue;
 		}
-		if (POI_iter->end_portal) {
-			if (starting_area || ending_area || !state_rainbow || state_flipped) {
-				continue;
-			}
-		}
 		float radius = (*POI_iter).Radius;
 		if (POI_iter->starting || POI_iter->end_portal) {
 			draw_filled_circle((*POI_iter).Position, glm::vec2(radius, radius), black_always_color, true);
 		} else if (POI_iter->rainbow) {
-			uint16_t c = 0;
+			//concentric circles, each a bit smaller than the last:
+			uint32_t rings = 0;
 			float decr = 1.0f;
 			for (float inner_radius = radius; inner_radius > 0.0f; inner_radius -= decr) {
-				draw_filled_circle((*POI_iter).Position, glm::vec2(inner_radius, inner_radius), (c == 2) ? rand_color() : rand_colors[c]);
+				rings += 1;
+				decr *= 0.85f;
+			}
+			//...drawn as one quad using the ring table, if they fit (otherwise, as separate circles):
+			bool as_rings = (list->ring_count + rings <= CircleProgram::MaxRings) && is_visible((*POI_iter).Position, glm::vec2(radius, radius));
+			uint32_t first = list->ring_count;
+			uint16_t c = 0;
+			decr = 1.0f;
+			for (float inner_radius = radius; inner_radius > 0.0f; inner_radius -= decr) {
+				glm::u8vec4 color = (c == 2) ? rand_color(draw_rng) : rand_colors[c];
+				if (as_rings) {
+					list->ring_colors[list->ring_count] = glm::vec4(color) / 255.0f;
+					list->ring_radii[list->ring_count] = inner_radius / radius;
+					list->ring_count += 1;
+				} else {
+					draw_filled_circle((*POI_iter).Position, glm::vec2(inner_radius, inner_radius), color);
+				}
 				c = (c + 1) % (sizeof(rand_colors) / sizeof(rand_colors[0]));
 				decr *= 0.85f;
 			}
+			if (as_rings && rings != 0) {
+				draw_circle_quad((*POI_iter).Position, glm::vec2(radius, radius), glm::u8vec4(0xff), glm::u8vec2(first, rings));
+			}
 		} else {
 			draw_filled_circle((*POI_iter).Position, glm::vec2(radius, radius), mauve_color);
 		}
@@ -684,20 +1194,12 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 
 	//ball's trail:
 	if (ball_trail.size() >= 2) {
-		//start ti at second element so there is always something before it to interpolate from:
-		std::deque< glm::vec3 >::iterator ti = ball_trail.begin() + 1;
 		//draw trail from oldest-to-newest:
 		for (uint32_t i = uint32_t(rainbow_colors.size())-1; i < rainbow_colors.size(); --i) {
-			//time at which to draw the trail element:
-			float t = (i + 1) / float(rainbow_colors.size()) * trail_length;
-			//advance ti until 'just before' t:
-			while (ti != ball_trail.end() && ti->z > t) ++ti;
-			//if we ran out of tail, stop drawing:
-			if (ti == ball_trail.end()) break;
-			//interpolate between previous and current trail point to the correct time:
-			glm::vec3 a = *(ti-1);
-			glm::vec3 b = *(ti);
-			glm::vec2 at = (t - a.z) / (b.z - a.z) * (glm::vec2(b) - glm::vec2(a)) + glm::vec2(a);
+			//how long ago the trail element should be drawn at:
+			float t = (i + 1) / float(rainbow_colors.size()) * trail_length + trail_offset;
+			//find where the ball was at that time:
+			glm::vec2 at = ball_trail.sample(trail_clock - t);
 			//draw:
 			//draw_rectangle(at, ball_radius, rainbow_colors[i]);
 			draw_filled_circle(at, ball_radius, rainbow_colors[i]);
@@ -705,102 +1207,66 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	}
 
 	//ball:
-	draw_filled_circle(ball, ball_radius, ball_color);
-
-
-
-	//------ compute court-to-window transform ------
-
-	//compute area that should be visible:
-	glm::vec2 scene_min = glm::vec2(
-		/*-court_radius.x - 2.0f * wall_radius - padding,
-		-court_radius.y - 2.0f * wall_radius - padding*/
-		camera_bounds_min.x,
-		camera_bounds_min.y
-	);
-	glm::vec2 scene_max = glm::vec2(
-		/*court_radius.x + 2.0f * wall_radius + padding,
-		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding*/
-		camera_bounds_max.x,
-		camera_bounds_max.y
-	);
-
-	//compute window aspect ratio:
-	float aspect = drawable_size.x / float(drawable_size.y);
-	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
-
-	//compute scale factor for court given that...
-	float scale = std::min(
-		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
-		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
-	);
-
-	if (state_flipped) {
-		scale = -scale;
+	draw_filled_circle(ball_at, ball_radius, ball_color);
+
+	//extra balls (there may be thousands, so these are kept cheap):
+	if (extra_balls.size() != 0) {
+		size_t count = extra_balls.size();
+		//trails, oldest first, as small squares faded like the main ball's trail:
+		for (uint32_t k = 0; k < extra_balls.trail_count; ++k) {
+			uint32_t slot = (extra_balls.trail_next + BallPool::TrailPoints - extra_balls.trail_count + k) % BallPool::TrailPoints;
+			glm::u8vec4 color = rainbow_colors[(extra_balls.trail_count - 1 - k) * rainbow_colors.size() / BallPool::TrailPoints];
+			float const *trail_x = extra_balls.trail_x.data() + slot * count;
+			float const *trail_y = extra_balls.trail_y.data() + slot * count;
+			for (size_t b = 0; b < count; ++b) {
+				draw_rectangle(glm::vec2(trail_x[b], trail_y[b]), 0.6f * ball_radius, color);
+			}
+		}
+		//balls:
+		for (size_t b = 0; b < count; ++b) {
+			glm::vec2 center = glm::vec2(extra_balls.x[b], extra_balls.y[b]);
+			if (!is_visible(center, ball_radius)) continue;
+			draw_circle_quad(center, ball_radius, ball_color, glm::u8vec2(0, 0));
+		}
 	}
 
-	glm::vec2 center = 0.5f * (scene_max + scene_min);
 
-	//build matrix that scales and translates appropriately:
-	glm::mat4 court_to_clip = glm::mat4(
-		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
-		glm::vec4(0.0f, scale, 0.0f, 0.0f),
-		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
-		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
-	);
-	//NOTE: glm matrices are specified in *Column-Major* order,
-	// so each line above is specifying a *column* of the matrix(!)
-
-	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
-	clip_to_court = glm::mat3x2(
-		glm::vec2(aspect / scale, 0.0f),
-		glm::vec2(0.0f, 1.0f / scale),
-		glm::vec2(center.x, center.y)
-	);
-
-	//---- actual drawing ----
-
-	//clear the color buffer:
-	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
-
-	//use alpha blending:
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	//don't use the depth test:
-	glDisable(GL_DEPTH_TEST);
-
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
-
-	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
-
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
 
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
-
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//fill in batch counts (each batch of 'indices' runs until the next one starts):
+	uint32_t batch_end = uint32_t(indices.size());
+	for (auto batch = list->batches.rbegin(); batch != list->batches.rend(); ++batch) {
+		if (batch->kind == DrawList::Batch::Static) continue;
+		batch->count = batch_end - batch->first;
+		batch_end = batch->first;
+	}
 
-	//reset vertex array to none:
-	glBindVertexArray(0);
+	//sprites, on top, as one batch per atlas page:
+	list->sprites.sort();
+	for (auto const &quad : list->sprites.quads) {
+		glm::vec2 at = 0.5f * (quad.max + quad.min);
+		glm::vec2 radius = 0.5f * (quad.max - quad.min);
+		if (!is_visible(at, radius)) continue;
+		if (list->batches.empty() || list->batches.back().kind != DrawList::Batch::Sprites || list->batches.back().page != quad.page) {
+			list->batches.emplace_back(DrawList::Batch{DrawList::Batch::Sprites, uint32_t(indices.size()), 0, quad.page});
+		}
+		add_quad_indices(uint32_t(vertices.size()));
+		vertices.emplace_back(glm::vec3(quad.min.x, quad.min.y, 0.0f), quad.color, glm::vec2(quad.min_uv.x, quad.min_uv.y));
+		vertices.emplace_back(glm::vec3(quad.max.x, quad.min.y, 0.0f), quad.color, glm::vec2(quad.max_uv.x, quad.min_uv.y));
+		vertices.emplace_back(glm::vec3(quad.max.x, quad.max.y, 0.0f), quad.color, glm::vec2(quad.max_uv.x, quad.max_uv.y));
+		vertices.emplace_back(glm::vec3(quad.min.x, quad.max.y, 0.0f), quad.color, glm::vec2(quad.min_uv.x, quad.max_uv.y));
+		list->batches.back().count += 6;
+	}
+	list->atlas = &atlas;
 
-	//reset current program to none:
-	glUseProgram(0);
-	
+	vertex_count_hint = vertices.size() + vertices.size() / 4;
+	compact_vertex_count_hint = compact_vertices.size() + compact_vertices.size() / 4;
+	circle_vertex_count_hint = circle_vertices.size() + circle_vertices.size() / 4;
+	index_count_hint = indices.size() + indices.size() / 4;
 
-	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+	assert(heap_allocation_count() - allocations_before - static_allocations == frame_arena.heap_blocks - arena_blocks_before && "PongMode::build_draw_list() allocated from the heap");
+	(void)allocations_before; (void)arena_blocks_before; (void)static_allocations; //(unused when NDEBUG is defined)
 
+	list->world_to_clip = world_to_clip;
+	list->compact_to_clip = compact_to_clip;
+	list->bg_color = bg_color;
 }
@@ -1,19 +1,31 @@
+#pragma once
+
 #include "ColorTextureProgram.hpp"
+#include "ColorProgram.hpp"
+#include "CircleProgram.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
+#include "BallTrail.hpp"
+#include "BallPool.hpp"
+#include "PongRules.hpp"
+#include "TextureAtlas.hpp"
+#include "SpriteBatch.hpp"
 
 #include <glm/glm.hpp>
 
 #include <vector>
-#include <deque>
+#include <memory>
+#include <cmath>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
  */
 
 struct PongMode : Mode {
-	PongMode();
+	//use_gl = false skips allocating OpenGL resources, so the game can be simulated without a context
+	// (e.g., headless replays); draw() must not be called on such a mode.
+	PongMode(bool use_gl = true);
 	virtual ~PongMode();
 
 	//functions called by main loop:
@@ -21,8 +33,35 @@ struct PongMode : Mode {
 	virtual void update_mouse_pos(glm::vec2 const& new_mouse_pos, glm::uvec2 const& window_size);
 	virtual void update(float elapsed, Window_settings& window_settings) override;
 	virtual void cycle_title(Mode::Window_settings &window_settings);
-	virtual glm::u8vec4 rand_color();
-	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual glm::u8vec4 rand_color(PCG32 &from);
+	virtual void fill_rand_colors(PCG32 &from, glm::u8vec4 *colors, size_t count);
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
+
+	//hash of the simulation state, used to check that replays are bit-exact:
+	uint32_t state_checksum() const;
+
+	//----- snapshots (for simulating on one thread and drawing on another) -----
+
+	//everything draw() reads that update() changes:
+	struct Snapshot {
+		double time = 0.0; //when this state was produced (seconds; caller-defined clock)
+		uint32_t input_time = 0; //timestamp of the newest input this state was stepped with (caller-defined clock)
+		glm::vec2 ball = glm::vec2(0.0f);
+		BallTrail ball_trail;
+		double trail_clock = 0.0;
+		BallPool extra_balls;
+		glm::vec2 camera_pos = glm::vec2(0.0f);
+		glm::vec2 paddles[9]; //starting, left, right, bottom, top, left_far, right_far, bottom_far, top_far
+		std::vector< uint8_t > bricks_deleted, bricks_flipped_deleted;
+		glm::u8vec4 rand_colors[10];
+		bool starting_area = true, ending_area = false, state_flipped = false, state_rainbow = false;
+		//window settings requested by update():
+		float opacity = 1.0f;
+		const char *title = nullptr;
+	};
+	void save_snapshot(Snapshot *snapshot) const;
+	//set drawn state to 'alpha' of the way from 'prev' to 'next' (jumps straight to 'next' across teleports):
+	void load_snapshot(Snapshot const &prev, Snapshot const &next, float alpha);
 
 	//----- settings -----
 
@@ -41,15 +80,12 @@ struct PongMode : Mode {
 	const float POI_opacity_radius_inner = 0.2f;
 	const float POI_opacity_radius_outer = 1.4f;
 
-	struct POI {
+	//(what touching one does -- flip, rainbow, starting, end_portal -- is in POIRule; see PongRules.hpp)
+	struct POI : POIRule {
 		POI(glm::vec2 const& Position_, float Radius_) :
 			Position(Position_), Radius(Radius_) { }
 		glm::vec2 Position;
 		float Radius;
-		bool flip = true;
-		bool rainbow = false;
-		bool starting = false;
-		bool end_portal = false;
 	};
 	std::vector< POI > POIs;
 
@@ -76,6 +112,10 @@ struct PongMode : Mode {
 	bool state_flipped = false;
 	bool state_rainbow = false;
 
+	//the four flags above, as the shared rules (PongRules.hpp) take them:
+	AreaState area_state() const;
+	void set_area_state(AreaState const &state);
+
 
 	//----- game state -----
 
@@ -162,8 +202,31 @@ struct PongMode : Mode {
 
 	glm::u8vec4 rand_colors[10];
 
+	//purely cosmetic randomness in draw() comes from here, so drawing doesn't perturb the simulation's 'rng':
+	PCG32 draw_rng = PCG32(0x2545f4914f6cdd1dULL);
+
 	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+	//trail gets coarser if updates come faster than this (instead of needing more points):
+	float trail_max_rate = 240.0f;
+	BallTrail ball_trail = BallTrail(trail_length, trail_max_rate);
+	double trail_clock = 0.0; //simulation time used to timestamp trail points
+	void restart_trail(); //set up trail as if ball has been here for 'forever'
+
+	//----- render interpolation -----
+	//state before the most recent update(), for drawing in between updates:
+	glm::vec2 ball_prev = glm::vec2(0.0f, 0.0f);
+	glm::vec2 camera_prev = glm::vec2(0.0f, 0.0f);
+	float last_elapsed = 0.0f;
+	bool trail_restarted = false; //set when the ball teleports; draw() shouldn't interpolate across that
+
+	//----- extra balls -----
+	//how many extra balls to put in play while in the main area (e.g., from the command line):
+	uint32_t extra_ball_count = 0;
+	//extra balls bounce off paddles, bricks (breaking them), blocks, the court edges, and each other;
+	// they don't interact with POIs:
+	BallPool extra_balls;
+	void spawn_extra_balls();
+	void update_extra_balls(float elapsed);
 
 	//----- opengl assets / helpers ------
 
@@ -177,21 +240,131 @@ struct PongMode : Mode {
 	};
 	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
 
+	//untextured triangles use a smaller vertex, with positions in fixed-point court units:
+	// (drawn with color_program; see DrawList::compact_to_clip)
+	struct CompactVertex {
+		static constexpr float Units = 512.0f; //fixed-point steps per court unit (so positions must be within about +/-64)
+		CompactVertex(glm::vec2 const &Position_, glm::u8vec4 const &Color_) :
+			Position(int16_t(std::floor(Position_.x * Units + 0.5f)), int16_t(std::floor(Position_.y * Units + 0.5f))), Color(Color_) { }
+		glm::i16vec2 Position;
+		glm::u8vec4 Color;
+	};
+	static_assert(sizeof(CompactVertex) == 2*2 + 1*4, "PongMode::CompactVertex should be packed");
+
+	//circles (and ring sets) are drawn as quads with circle_program, using vertices like this:
+	struct CircleVertex {
+		CircleVertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &Local_, glm::u8vec2 const &Rings_) :
+			Position(Position_), Color(Color_), Local(Local_), Rings(Rings_) { }
+		glm::vec3 Position;
+		glm::u8vec4 Color; //color of solid circles
+		glm::vec2 Local; //position relative to the center, in radii
+		glm::u8vec2 Rings; //(first, count) in DrawList's ring table; count == 0 for solid circles
+		uint8_t padding[2] = {0, 0};
+	};
+	static_assert(sizeof(CircleVertex) == 4*3 + 1*4 + 4*2 + 1*2 + 2, "PongMode::CircleVertex should be packed");
+
+	//walls, corner blocks, and bricks only change with game state, so their triangles are kept between frames:
+	// (rebuilt by build_draw_list() when the area, flip state, or colors change, or after invalidate_static_geometry())
+	struct StaticGeometry {
+		std::vector< CompactVertex > vertices; //world space
+		std::vector< uint32_t > indices;
+		uint32_t revision = 0; //incremented on every rebuild (so draw() knows when to re-upload)
+		//what the geometry was built from:
+		uint32_t generation = -1U; //static_geometry_generation
+		bool starting_area = false, ending_area = false, state_flipped = false;
+		glm::u8vec4 wall_color = glm::u8vec4(0), brick_color = glm::u8vec4(0);
+	};
+	StaticGeometry static_geometry;
+	uint32_t static_geometry_generation = 0;
+	//call when static geometry changes in a way build_draw_list() can't see (e.g., a brick was deleted):
+	void invalidate_static_geometry() { static_geometry_generation += 1; }
+
+	//sprite images, packed into pages at load time (draw with DrawList::sprites):
+	TextureAtlas atlas;
+
+	//everything draw() hands to OpenGL for one frame:
+	// (all positions are in world space; the camera is part of world_to_clip)
+	struct DrawList {
+		DrawList(FrameArena &arena) : vertices(arena), compact_vertices(arena), circle_vertices(arena), indices(arena), batches(arena), sprites(arena) { }
+		ArenaVector< Vertex > vertices; //drawn with color_texture_program and a white texture (only for positions CompactVertex can't hold)
+		ArenaVector< CompactVertex > compact_vertices; //drawn with color_program
+		ArenaVector< CircleVertex > circle_vertices; //four per circle, drawn with circle_program
+		//triangles, as indices into one of the vertex arrays (depending on the batch they are in):
+		// (shared corners are stored once, so a rectangle or circle is four vertices and six indices)
+		ArenaVector< uint32_t > indices;
+		//runs of indices, in the order they are drawn:
+		struct Batch {
+			enum Kind : uint8_t {
+				Triangles, //indexing 'vertices'
+				CompactTriangles, //indexing 'compact_vertices'
+				Circles, //indexing 'circle_vertices'
+				Static, //indexing static_geometry->vertices
+				Sprites, //indexing 'vertices', textured with atlas page 'page'
+			} kind;
+			uint32_t first, count; //range of 'indices' (or static_geometry->indices, for Static)
+			uint32_t page = 0; //for Sprites
+		};
+		ArenaVector< Batch > batches;
+		//sprites from 'atlas', drawn on top of everything else with one Sprites batch per page:
+		// (build_draw_list() turns these into vertices and batches at the end)
+		SpriteBatch sprites;
+		TextureAtlas const *atlas = nullptr;
+		//ring table for circles drawn as concentric rings (RING_COLORS / RING_RADII in circle_program):
+		glm::vec4 ring_colors[CircleProgram::MaxRings];
+		float ring_radii[CircleProgram::MaxRings];
+		uint32_t ring_count = 0;
+		StaticGeometry const *static_geometry = nullptr;
+		glm::mat4 world_to_clip = glm::mat4(1.0f); //OBJECT_TO_CLIP for 'vertices' and 'circle_vertices'
+		glm::mat4 compact_to_clip = glm::mat4(1.0f); //...and for 'compact_vertices' and static geometry (world_to_clip, scaled by 1 / CompactVertex::Units)
+		glm::u8vec4 bg_color = glm::u8vec4(0x00, 0x00, 0x00, 0xff); //clear color
+	};
+	//the CPU half of draw(): builds the frame's geometry without any OpenGL calls
+	// (so it also works on a mode constructed without OpenGL, e.g., for benchmarks):
+	void build_draw_list(glm::uvec2 const &drawable_size, float alpha, DrawList *list);
+
 	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
+	// (null if constructed without OpenGL)
+	std::unique_ptr< ColorTextureProgram > color_texture_program;
+	//Shader program that draws CompactVertex triangles:
+	std::unique_ptr< ColorProgram > color_program;
+	//Shader program that draws circles with anti-aliased edges:
+	std::unique_ptr< CircleProgram > circle_program;
+
+	//number of vertices to reserve room for in draw() (based on the previous frame):
+	size_t vertex_count_hint = 0;
+	size_t compact_vertex_count_hint = 4096;
+	size_t circle_vertex_count_hint = 256;
+	size_t index_count_hint = 4096;
 
 	//Buffer used to hold vertex data during drawing:
 	GLuint vertex_buffer = 0;
+	GLuint compact_vertex_buffer = 0;
+	GLuint circle_vertex_buffer = 0;
+	//...and index data (16-bit if the frame has few enough vertices, 32-bit otherwise):
+	GLuint index_buffer = 0;
 
 	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
 	GLuint vertex_buffer_for_color_texture_program = 0;
+	//...compact_vertex_buffer to color_program attribute locations:
+	GLuint compact_vertex_buffer_for_color_program = 0;
+	//...and static geometry, which is only uploaded when it changes:
+	GLuint static_vertex_buffer = 0;
+	GLuint static_index_buffer = 0;
+	GLuint static_vertex_buffer_for_color_program = 0;
+	uint32_t static_revision_uploaded = -1U;
+	GLenum static_index_type = GL_UNSIGNED_INT;
+	//...and circle_vertex_buffer to circle_program attribute locations:
+	GLuint circle_vertex_buffer_for_circle_program = 0;
 
 	//Solid white texture:
 	GLuint white_tex = 0;
+	//...and one texture per atlas page (uploaded when the atlas is re-packed):
+	std::vector< GLuint > atlas_textures;
+	uint32_t atlas_revision_uploaded = 0;
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
+	// computed in build_draw_list() as the inverse of OBJECT_TO_CLIP
 	// (stored here so that the mouse handling code can use it to position the paddle)
 
 };
@@ -0,0 +1,145 @@
+#include "PongRules.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool ball_vs_rect(glm::vec2 const &rect, glm::vec2 const &radius, bool velo_warp, glm::vec2 const &ball_radius, glm::vec2 *ball_, glm::vec2 *velocity_) {
+	glm::vec2 &ball = *ball_;
+	glm::vec2 &ball_velocity = *velocity_;
+
+	//compute area of overlap:
+	glm::vec2 min = glm::max(rect - radius, ball - ball_radius);
+	glm::vec2 max = glm::min(rect + radius, ball + ball_radius);
+
+	//if no overlap, no collision:
+	if (min.x > max.x || min.y > max.y) return false;
+
+	if (max.x - min.x > max.y - min.y) {
+		//wider overlap in x => bounce in y direction:
+		if (ball.y > rect.y) {
+			ball.y = rect.y + radius.y + ball_radius.y;
+			ball_velocity.y = std::abs(ball_velocity.y);
+		} else {
+			ball.y = rect.y - radius.y - ball_radius.y;
+			ball_velocity.y = -std::abs(ball_velocity.y);
+		}
+		//warp x velocity based on offset from paddle center:
+		if (velo_warp) {
+			float og_speed = std::sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
+			float vel = (ball.x - rect.x) / (radius.x + ball_radius.x);
+			ball_velocity.x = glm::mix(ball_velocity.x, vel, 0.75f);
+			ball_velocity /= std::sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
+			ball_velocity *= og_speed;
+		}
+	} else {
+		//wider overlap in y => bounce in x direction:
+		if (ball.x > rect.x) {
+			ball.x = rect.x + radius.x + ball_radius.x;
+			ball_velocity.x = std::abs(ball_velocity.x);
+		} else {
+			ball.x = rect.x - radius.x - ball_radius.x;
+			ball_velocity.x = -std::abs(ball_velocity.x);
+		}
+		//warp y velocity based on offset from paddle center:
+		if (velo_warp) {
+			float og_speed = std::sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
+			float vel = (ball.y - rect.y) / (radius.y + ball_radius.y);
+			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+			ball_velocity /= std::sqrt(ball_velocity.x * ball_velocity.x + ball_velocity.y * ball_velocity.y);
+			ball_velocity *= og_speed;
+		}
+	}
+	return true;
+}
+
+uint32_t ball_vs_bounds(glm::vec2 const &bounds, glm::vec2 const &ball_radius, glm::vec2 *ball_, glm::vec2 *velocity_) {
+	glm::vec2 &ball = *ball_;
+	glm::vec2 &ball_velocity = *velocity_;
+
+	uint32_t bounces = 0;
+	if (ball.y > bounds.y - ball_radius.y) {
+		ball.y = bounds.y - ball_radius.y;
+		if (ball_velocity.y > 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+		bounces += 1;
+	}
+	if (ball.y < -bounds.y + ball_radius.y) {
+		ball.y = -bounds.y + ball_radius.y;
+		if (ball_velocity.y < 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+		bounces += 1;
+	}
+	if (ball.x > bounds.x - ball_radius.x) {
+		ball.x = bounds.x - ball_radius.x;
+		if (ball_velocity.x > 0.0f) {
+			ball_velocity.x = -ball_velocity.x;
+		}
+		bounces += 1;
+	}
+	if (ball.x < -bounds.x + ball_radius.x) {
+		ball.x = -bounds.x + ball_radius.x;
+		if (ball_velocity.x < 0.0f) {
+			ball_velocity.x = -ball_velocity.x;
+		}
+		bounces += 1;
+	}
+	return bounces;
+}
+
+PaddlePlacement place_paddles(glm::vec2 const &target, float start_dist, glm::vec2 const &base_court_radius, glm::vec2 const &extreme_radius,
+	glm::vec2 const &vert_paddle_radius, glm::vec2 const &horiz_paddle_radius) {
+	PaddlePlacement placement;
+	placement.starting_x = std::min(std::max(target.x, -2.5f * start_dist + horiz_paddle_radius.x * 1.5f), 2.5f * start_dist - horiz_paddle_radius.x * 1.5f);
+	placement.near_x = std::min(std::max(target.x, -base_court_radius.x + horiz_paddle_radius.x * 1.5f), base_court_radius.x - horiz_paddle_radius.x * 1.5f);
+	placement.near_y = std::min(std::max(target.y, -base_court_radius.y + vert_paddle_radius.y * 1.5f), base_court_radius.y - vert_paddle_radius.y * 1.5f);
+	placement.far_x = std::min(std::max(target.x, -extreme_radius.x + horiz_paddle_radius.x * 1.5f), extreme_radius.x - horiz_paddle_radius.x * 1.5f);
+	placement.far_y = std::min(std::max(target.y, -extreme_radius.y + vert_paddle_radius.y * 1.5f), extreme_radius.y - vert_paddle_radius.y * 1.5f);
+	return placement;
+}
+
+bool poi_active(POIRule const &poi, AreaState const &state) {
+	if (poi.starting != state.starting_area) return false;
+	if (poi.end_portal && (state.starting_area || state.ending_area || !state.rainbow || state.flipped)) return false;
+	return true;
+}
+
+bool ball_enters_poi(POIRule const &poi, glm::vec2 const &normal, glm::vec2 *ball, glm::vec2 *velocity, AreaState *state) {
+	if (poi.rainbow) {
+		state->rainbow = !state->rainbow;
+	}
+	if (poi.flip) {
+		state->flipped = !state->flipped;
+		*velocity = -*velocity;
+	} else {
+		float dot_product = velocity->x * normal.x + velocity->y * normal.y;
+		glm::vec2 projection = dot_product * normal;
+		*velocity -= projection * 2.0f;
+	}
+	if (poi.starting) {
+		state->starting_area = false;
+		state->flipped = false;
+		*ball = glm::vec2(0.0f, 0.0f);
+		return true;
+	}
+	if (poi.end_portal) {
+		state->ending_area = true;
+		state->flipped = false;
+		*ball = glm::vec2(0.0f, 0.0f);
+		return true;
+	}
+	return false;
+}
+
+void spawn_extra_balls(BallPool *balls, PCG32 &rng, uint32_t count, float radius, float trail_length, glm::vec2 const &base_court_radius) {
+	balls->clear();
+	balls->radius = radius;
+	balls->trail_length = trail_length;
+	glm::vec2 spread = base_court_radius - glm::vec2(1.0f);
+	for (uint32_t i = 0; i < count; ++i) {
+		glm::vec2 position = glm::vec2(rng.unit() * 2.0f - 1.0f, rng.unit() * 2.0f - 1.0f) * spread;
+		float angle = rng.unit() * 2.0f * 3.14159265358979323846f; //(M_PI isn't standard C++)
+		balls->add(position, glm::vec2(std::cos(angle), std::sin(angle)));
+	}
+}
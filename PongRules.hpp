@@ -0,0 +1,93 @@
+#pragma once
+
+#include "BallPool.hpp"
+#include "PCG32.hpp"
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+/*
+ * The rules of Pongoria's ball, paddles, and areas, shared by PongMode::update (one game, plus
+ *  cosmetic side effects like title cycling and trails) and PongBatch (many games, stored
+ *  structure-of-arrays), so the two can't drift apart.
+ *
+ * Functions only change the state passed to them; callers keep the level layout
+ *  (PongMode's members, or PongBatch::Level, which is copied from them).
+ */
+
+//bounce a ball (half-size 'ball_radius') off a rectangle (center 'rect', half-size 'radius').
+//'velo_warp' bends the bounce based on where the ball hit, as paddles do.
+//returns true if they overlapped:
+bool ball_vs_rect(glm::vec2 const &rect, glm::vec2 const &radius, bool velo_warp, glm::vec2 const &ball_radius, glm::vec2 *ball, glm::vec2 *velocity);
+
+//keep a ball inside [-bounds, bounds]; returns the number of edges it bounced off:
+uint32_t ball_vs_bounds(glm::vec2 const &bounds, glm::vec2 const &ball_radius, glm::vec2 *ball, glm::vec2 *velocity);
+
+//where paddles go when tracking court-space point 'target', clamped to their courts:
+struct PaddlePlacement {
+	float starting_x; //starting paddle
+	float near_x, near_y; //bottom/top and left/right paddles
+	float far_x, far_y; //bottom_far/top_far and left_far/right_far paddles
+};
+PaddlePlacement place_paddles(glm::vec2 const &target, float start_dist, glm::vec2 const &base_court_radius, glm::vec2 const &extreme_radius,
+	glm::vec2 const &vert_paddle_radius, glm::vec2 const &horiz_paddle_radius);
+
+//which area a game is in, and the flags POIs toggle:
+struct AreaState {
+	bool starting_area = true;
+	bool ending_area = false;
+	bool flipped = false;
+	bool rainbow = false;
+};
+
+//what a POI does when the ball touches it:
+struct POIRule {
+	bool flip = true; //flip the brick set (and reverse the ball); otherwise, bounce off it
+	bool rainbow = false; //toggle rainbow
+	bool starting = false; //leave the starting area for the main area (only exists in the starting area)
+	bool end_portal = false; //leave the main area for the ending area (only open while rainbow and not flipped)
+};
+
+//is the POI there at all in this state?
+bool poi_active(POIRule const &poi, AreaState const &state);
+
+//apply a POI to a ball touching it ('normal' is the unit vector from the ball to the POI's center).
+//returns true if the ball moved to another area (it is now at the origin);
+// otherwise the caller puts the ball back on the POI's edge:
+bool ball_enters_poi(POIRule const &poi, glm::vec2 const &normal, glm::vec2 *ball, glm::vec2 *velocity, AreaState *state);
+
+//----- extra balls (main area only) -----
+
+//the main area's paddles as placed for one step, and its fixed pieces:
+struct MainAreaLayout {
+	glm::vec2 paddles[8]; //left, right, bottom, top, left_far, right_far, bottom_far, top_far
+	glm::vec2 vert_paddle_radius, horiz_paddle_radius;
+	glm::vec2 blocks[4]; //TR, BR, BL, TL
+	glm::vec2 block_radius;
+	glm::vec2 extreme_radius;
+};
+
+//scatter 'count' extra balls around the inner court, heading in random directions:
+void spawn_extra_balls(BallPool *balls, PCG32 &rng, uint32_t count, float radius, float trail_length, glm::vec2 const &base_court_radius);
+
+//move extra balls and bounce them off the paddles, bricks, corner blocks, court edges, and each other.
+//'hit_bricks(balls)' handles the bricks (it should collide_rect each live brick and remove any that were hit):
+template< typename HitBricks >
+void update_extra_balls(BallPool *balls, float elapsed, MainAreaLayout const &layout, HitBricks &&hit_bricks) {
+	//each piece of geometry is checked against all of the balls at once:
+	balls->move(elapsed);
+
+	for (uint32_t p = 0; p < 8; ++p) {
+		balls->collide_rect(layout.paddles[p], (p % 4 < 2 ? layout.vert_paddle_radius : layout.horiz_paddle_radius), true);
+	}
+
+	hit_bricks(*balls);
+
+	for (uint32_t b = 0; b < 4; ++b) {
+		balls->collide_rect(layout.blocks[b], layout.block_radius, false);
+	}
+
+	balls->collide_bounds(layout.extreme_radius);
+	balls->collide_balls(layout.extreme_radius);
+}
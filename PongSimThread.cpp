@@ -0,0 +1,83 @@
+#include "PongSimThread.hpp"
+
+#include <cassert>
+
+PongSimThread::PongSimThread(float rate_hz, uint32_t extra_ball_count_) : step(1.0f / rate_hz), extra_ball_count(extra_ball_count_) {
+	assert(rate_hz > 0.0f);
+	start = std::chrono::steady_clock::now();
+	thread = std::thread(&PongSimThread::run, this);
+}
+
+PongSimThread::~PongSimThread() {
+	quit = true;
+	thread.join();
+}
+
+double PongSimThread::now() const {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+}
+
+void PongSimThread::set_mouse(glm::vec2 const &absolute_mouse_pos, uint32_t input_time) {
+	std::unique_lock< std::mutex > lock(mouse_mutex);
+	mouse = absolute_mouse_pos;
+	mouse_time = input_time;
+}
+
+void PongSimThread::run() {
+	PongMode sim(false);
+	sim.extra_ball_count = extra_ball_count;
+	const char *title = "";
+
+	double tick = now(); //time the current step is scheduled for
+	while (!quit) {
+		uint32_t input_time;
+		{
+			std::unique_lock< std::mutex > lock(mouse_mutex);
+			sim.absolute_mouse_pos = mouse;
+			input_time = mouse_time;
+		}
+		Mode::Window_settings window_settings = Mode::Window_settings(glm::uvec2(0), glm::uvec2(0), 1.0f, &title);
+		sim.update(step, window_settings);
+		title = *window_settings.title;
+
+		PongMode::Snapshot &snapshot = snapshots.write_buffer();
+		sim.save_snapshot(&snapshot);
+		snapshot.time = tick;
+		snapshot.input_time = input_time;
+		snapshot.opacity = window_settings.opacity;
+		snapshot.title = title;
+		snapshots.publish();
+
+		tick += step;
+		//if the simulation fell far behind (e.g., the process was suspended), skip ahead instead of racing to catch up:
+		if (now() - tick > 0.1) {
+			tick = now();
+		}
+		std::this_thread::sleep_until(start + std::chrono::duration_cast< std::chrono::steady_clock::duration >(std::chrono::duration< double >(tick)));
+	}
+}
+
+PongMode::Snapshot const &PongSimThread::load_into(PongMode *pong) {
+	assert(pong);
+	//wait for the very first snapshot:
+	while (!have_snapshot && !snapshots.fetch()) {
+		std::this_thread::yield();
+	}
+	if (!have_snapshot) {
+		prev = next = snapshots.read_buffer();
+		have_snapshot = true;
+	} else if (snapshots.fetch()) {
+		std::swap(prev, next);
+		next = snapshots.read_buffer();
+	}
+
+	//draw one step in the past, so there is (usually) a snapshot on either side to interpolate between:
+	double render_time = now() - step;
+	float alpha = 1.0f;
+	if (next.time > prev.time) {
+		alpha = float((render_time - prev.time) / (next.time - prev.time));
+	}
+	pong->load_snapshot(prev, next, alpha);
+	drawn_input_time = (alpha > 0.0f ? next.input_time : prev.input_time);
+	return next;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "PongMode.hpp"
+#include "TripleBuffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+/*
+ * PongSimThread runs a (headless) PongMode at a fixed rate on its own thread and
+ *  publishes a PongMode::Snapshot after every step through a TripleBuffer.
+ * The render thread feeds in mouse positions and draws snapshots, interpolated
+ *  between the two most recent ones, at whatever rate the display runs.
+ */
+
+struct PongSimThread {
+	explicit PongSimThread(float rate_hz, uint32_t extra_ball_count = 0);
+	~PongSimThread(); //stops and joins the thread
+
+	//court-space mouse position the simulation should use from its next step on.
+	//'input_time' is the timestamp of the input it came from; snapshots stepped with it carry it as Snapshot::input_time:
+	void set_mouse(glm::vec2 const &absolute_mouse_pos, uint32_t input_time = 0);
+
+	//----- render thread side -----
+	//pick up any new snapshot and load the interpolated state for 'now' into 'pong' (for drawing).
+	//returns the newest snapshot (for window settings).
+	PongMode::Snapshot const &load_into(PongMode *pong);
+	//input_time of the snapshot load_into() mostly drew (prev, until interpolation starts moving toward next):
+	uint32_t drawn_input_time = 0;
+
+	float step; //seconds per simulation step
+	uint32_t extra_ball_count; //passed along to the simulated PongMode
+
+	//----- internals -----
+	void run();
+
+	std::mutex mouse_mutex;
+	glm::vec2 mouse = glm::vec2(0.0f);
+	uint32_t mouse_time = 0;
+
+	TripleBuffer< PongMode::Snapshot > snapshots;
+	//render side copies of the two newest snapshots:
+	PongMode::Snapshot prev, next;
+	bool have_snapshot = false;
+
+	std::chrono::steady_clock::time_point start;
+	double now() const;
+
+	std::atomic< bool > quit{false};
+	std::thread thread;
+};
@@ -0,0 +1,458 @@
+#include "SoftRasterizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFT_RASTERIZER_SSE
+#include <emmintrin.h>
+#endif
+
+constexpr uint32_t SoftRasterizer::TileSize;
+
+SoftRasterizer::SoftRasterizer(uint32_t thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::max(1U, std::thread::hardware_concurrency());
+	}
+	//the calling thread also rasters tiles, so start one fewer worker:
+	for (uint32_t t = 1; t < thread_count; ++t) {
+		workers.emplace_back(&SoftRasterizer::worker_main, this);
+	}
+}
+
+SoftRasterizer::~SoftRasterizer() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	work_cv.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void SoftRasterizer::resize(glm::uvec2 const &size_) {
+	size = size_;
+	pixels.assign(size_t(size.x) * size.y, glm::u8vec4(0x00, 0x00, 0x00, 0xff));
+	tiles_x = (size.x + TileSize - 1) / TileSize;
+	tiles_y = (size.y + TileSize - 1) / TileSize;
+	tile_triangles.resize(size_t(tiles_x) * tiles_y);
+}
+
+void SoftRasterizer::clear(glm::u8vec4 const &color) {
+	std::fill(pixels.begin(), pixels.end(), color);
+}
+
+void SoftRasterizer::render(PongMode::DrawList const &list) {
+	//copy atlas pages, if the atlas was re-packed since last time:
+	if (list.atlas && list.atlas->revision != atlas_revision) {
+		atlas_pages.resize(list.atlas->pages.size());
+		for (uint32_t i = 0; i < atlas_pages.size(); ++i) {
+			atlas_pages[i].size = list.atlas->page_size;
+			atlas_pages[i].data = list.atlas->pages[i];
+		}
+		atlas_revision = list.atlas->revision;
+	}
+
+	clear(list.bg_color);
+	for (auto const &batch : list.batches) {
+		if (batch.kind == PongMode::DrawList::Batch::Triangles) {
+			draw(list.vertices.data(), list.indices.data() + batch.first, batch.count, list.world_to_clip);
+		} else if (batch.kind == PongMode::DrawList::Batch::Sprites) {
+			draw(list.vertices.data(), list.indices.data() + batch.first, batch.count, list.world_to_clip, &atlas_pages[batch.page]);
+		} else if (batch.kind == PongMode::DrawList::Batch::Static) {
+			draw_compact(list.static_geometry->vertices.data(), list.static_geometry->indices.data() + batch.first, batch.count, list.compact_to_clip);
+		} else if (batch.kind == PongMode::DrawList::Batch::CompactTriangles) {
+			draw_compact(list.compact_vertices.data(), list.indices.data() + batch.first, batch.count, list.compact_to_clip);
+		} else {
+			draw_circles(list.circle_vertices.data(), list.indices.data() + batch.first, batch.count, list.world_to_clip, list.ring_colors, list.ring_radii);
+		}
+	}
+}
+
+void SoftRasterizer::begin_triangles() {
+	triangles.clear();
+	for (auto &list : tile_triangles) {
+		list.clear();
+	}
+}
+
+bool SoftRasterizer::setup_triangle(glm::vec4 const clip[3], Triangle *tri_, uint32_t order[3]) const {
+	Triangle &tri = *tri_;
+	glm::vec2 viewport_scale = 0.5f * glm::vec2(size);
+	glm::vec2 win[3];
+	for (uint32_t k = 0; k < 3; ++k) {
+		if (!(clip[k].w > 0.0f)) return false;
+		//viewport transform, then snap to 1/256 pixel (like GL's sub-pixel precision):
+		glm::vec2 w = (glm::vec2(clip[k]) / clip[k].w + 1.0f) * viewport_scale;
+		win[k] = glm::round(w * 256.0f) / 256.0f;
+	}
+
+	order[0] = 0; order[1] = 1; order[2] = 2;
+	float area2 = (win[1].x - win[0].x) * (win[2].y - win[0].y) - (win[1].y - win[0].y) * (win[2].x - win[0].x);
+	if (area2 == 0.0f || !std::isfinite(area2)) return false;
+	if (area2 < 0.0f) {
+		//rasterize everything counterclockwise (no culling, just like PongMode's draw):
+		std::swap(order[1], order[2]);
+		std::swap(win[1], win[2]);
+		area2 = -area2;
+	}
+
+	tri.inv_area = 1.0f / area2;
+	for (uint32_t k = 0; k < 3; ++k) {
+		//edge k is the one across from vertex k, so its value is vertex k's barycentric weight:
+		glm::vec2 const &a = win[(k + 1) % 3];
+		glm::vec2 const &b = win[(k + 2) % 3];
+		glm::vec2 d = b - a;
+		tri.origin[k] = a;
+		tri.normal[k] = glm::vec2(-d.y, d.x);
+		//(counterclockwise with y up: left edges go down, top edges go left)
+		tri.inclusive[k] = (d.y < 0.0f || (d.y == 0.0f && d.x < 0.0f));
+	}
+
+	//pixels whose centers could be inside:
+	glm::vec2 lo = glm::min(win[0], glm::min(win[1], win[2]));
+	glm::vec2 hi = glm::max(win[0], glm::max(win[1], win[2]));
+	tri.min = glm::max(glm::ivec2(glm::ceil(lo - 0.5f)), glm::ivec2(0));
+	tri.max = glm::min(glm::ivec2(glm::floor(hi - 0.5f)), glm::ivec2(size) - 1);
+	return tri.min.x <= tri.max.x && tri.min.y <= tri.max.y;
+}
+
+void SoftRasterizer::bin_triangle(Triangle const &tri) {
+	//bin into every tile the bounds touch:
+	uint32_t index = uint32_t(triangles.size());
+	triangles.emplace_back(tri);
+	for (int32_t ty = tri.min.y / int32_t(TileSize); ty <= tri.max.y / int32_t(TileSize); ++ty) {
+		for (int32_t tx = tri.min.x / int32_t(TileSize); tx <= tri.max.x / int32_t(TileSize); ++tx) {
+			tile_triangles[size_t(ty) * tiles_x + tx].emplace_back(index);
+		}
+	}
+}
+
+void SoftRasterizer::draw(PongMode::Vertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip, Texture const *texture) {
+	assert(count % 3 == 0);
+	if (pixels.empty()) return;
+
+	//----- setup -----
+	begin_triangles();
+	for (size_t i = 0; i + 2 < count; i += 3) {
+		size_t corner[3]; //(which vertices the triangle uses)
+		glm::vec4 clip[3];
+		for (uint32_t k = 0; k < 3; ++k) {
+			corner[k] = (indices ? indices[i + k] : i + k);
+			clip[k] = object_to_clip * glm::vec4(vertices[corner[k]].Position, 1.0f);
+		}
+		Triangle tri;
+		uint32_t order[3];
+		if (!setup_triangle(clip, &tri, order)) continue;
+
+		tri.circle = false;
+		for (uint32_t k = 0; k < 3; ++k) {
+			PongMode::Vertex const &v = vertices[corner[order[k]]];
+			tri.color[k] = glm::vec4(v.Color) / 255.0f;
+			tri.tex_coord[k] = v.TexCoord;
+		}
+		//(blending an opaque color over anything just gives back that color)
+		PongMode::Vertex const &v0 = vertices[corner[0]];
+		tri.opaque_flat = (texture == nullptr && v0.Color.a == 0xff && v0.Color == vertices[corner[1]].Color && v0.Color == vertices[corner[2]].Color);
+		tri.flat_color = v0.Color;
+
+		bin_triangle(tri);
+	}
+	if (triangles.empty()) return;
+
+	//----- raster -----
+	current_texture = texture;
+	run_tiles();
+	current_texture = nullptr;
+}
+
+void SoftRasterizer::draw_compact(PongMode::CompactVertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip) {
+	assert(count % 3 == 0);
+	if (pixels.empty()) return;
+
+	//----- setup -----
+	begin_triangles();
+	for (size_t i = 0; i + 2 < count; i += 3) {
+		size_t corner[3]; //(which vertices the triangle uses)
+		glm::vec4 clip[3];
+		for (uint32_t k = 0; k < 3; ++k) {
+			corner[k] = (indices ? indices[i + k] : i + k);
+			clip[k] = object_to_clip * glm::vec4(glm::vec2(vertices[corner[k]].Position), 0.0f, 1.0f);
+		}
+		Triangle tri;
+		uint32_t order[3];
+		if (!setup_triangle(clip, &tri, order)) continue;
+
+		tri.circle = false;
+		for (uint32_t k = 0; k < 3; ++k) {
+			tri.color[k] = glm::vec4(vertices[corner[order[k]]].Color) / 255.0f;
+			tri.tex_coord[k] = glm::vec2(0.5f, 0.5f);
+		}
+		PongMode::CompactVertex const &v0 = vertices[corner[0]];
+		tri.opaque_flat = (v0.Color.a == 0xff && v0.Color == vertices[corner[1]].Color && v0.Color == vertices[corner[2]].Color);
+		tri.flat_color = v0.Color;
+
+		bin_triangle(tri);
+	}
+	if (triangles.empty()) return;
+
+	//----- raster -----
+	run_tiles();
+}
+
+void SoftRasterizer::draw_circles(PongMode::CircleVertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip, glm::vec4 const *ring_colors, float const *ring_radii) {
+	assert(count % 3 == 0);
+	if (pixels.empty()) return;
+
+	//----- setup -----
+	begin_triangles();
+	for (size_t i = 0; i + 2 < count; i += 3) {
+		size_t corner[3]; //(which vertices the triangle uses)
+		glm::vec4 clip[3];
+		for (uint32_t k = 0; k < 3; ++k) {
+			corner[k] = (indices ? indices[i + k] : i + k);
+			clip[k] = object_to_clip * glm::vec4(vertices[corner[k]].Position, 1.0f);
+		}
+		Triangle tri;
+		uint32_t order[3];
+		if (!setup_triangle(clip, &tri, order)) continue;
+
+		tri.circle = true;
+		tri.opaque_flat = false; //(edges are always blended)
+		tri.rings = vertices[corner[0]].Rings;
+		assert(tri.rings.y == 0 || (ring_colors && ring_radii));
+		tri.local_dx = tri.local_dy = glm::vec2(0.0f);
+		for (uint32_t k = 0; k < 3; ++k) {
+			PongMode::CircleVertex const &v = vertices[corner[order[k]]];
+			tri.color[k] = glm::vec4(v.Color) / 255.0f;
+			tri.local[k] = v.Local;
+			//local = sum of weight k * local[k], and weight k changes by normal[k] * inv_area per pixel:
+			tri.local_dx += tri.normal[k].x * tri.inv_area * v.Local;
+			tri.local_dy += tri.normal[k].y * tri.inv_area * v.Local;
+		}
+
+		bin_triangle(tri);
+	}
+	if (triangles.empty()) return;
+
+	//----- raster -----
+	current_ring_colors = ring_colors;
+	current_ring_radii = ring_radii;
+	run_tiles();
+	current_ring_colors = nullptr;
+	current_ring_radii = nullptr;
+}
+
+void SoftRasterizer::run_tiles() {
+	next_tile.store(0);
+	if (!workers.empty()) {
+		std::unique_lock< std::mutex > lock(mutex);
+		working = uint32_t(workers.size());
+		generation += 1;
+	}
+	work_cv.notify_all();
+
+	uint32_t tile_count = tiles_x * tiles_y;
+	for (uint32_t tile = next_tile.fetch_add(1); tile < tile_count; tile = next_tile.fetch_add(1)) {
+		raster_tile(tile);
+	}
+
+	if (!workers.empty()) {
+		std::unique_lock< std::mutex > lock(mutex);
+		done_cv.wait(lock, [this](){ return working == 0; });
+	}
+}
+
+void SoftRasterizer::worker_main() {
+	uint64_t seen_generation = 0;
+	while (true) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			work_cv.wait(lock, [&](){ return quit || generation != seen_generation; });
+			if (quit) return;
+			seen_generation = generation;
+		}
+
+		uint32_t tile_count = tiles_x * tiles_y;
+		for (uint32_t tile = next_tile.fetch_add(1); tile < tile_count; tile = next_tile.fetch_add(1)) {
+			raster_tile(tile);
+		}
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			working -= 1;
+		}
+		done_cv.notify_one();
+	}
+}
+
+//bilinear filtering with GL_REPEAT wrapping (white_tex's settings; there are no mipmaps to pick from):
+static glm::vec4 sample(SoftRasterizer::Texture const &texture, glm::vec2 const &tex_coord) {
+	if (texture.size.x == 0 || texture.size.y == 0) return glm::vec4(1.0f);
+	glm::vec2 at = tex_coord * glm::vec2(texture.size) - 0.5f;
+	glm::vec2 base = glm::floor(at);
+	glm::vec2 amt = at - base;
+	auto texel = [&](int32_t x, int32_t y) {
+		int32_t w = int32_t(texture.size.x), h = int32_t(texture.size.y);
+		x = ((x % w) + w) % w;
+		y = ((y % h) + h) % h;
+		return glm::vec4(texture.data[size_t(y) * texture.size.x + x]) / 255.0f;
+	};
+	int32_t x = int32_t(base.x), y = int32_t(base.y);
+	return glm::mix(
+		glm::mix(texel(x, y), texel(x + 1, y), amt.x),
+		glm::mix(texel(x, y + 1), texel(x + 1, y + 1), amt.x),
+		amt.y
+	);
+}
+
+//CircleProgram's fragment shader:
+static glm::vec4 shade_circle(SoftRasterizer::Triangle const &tri, float w0, float w1, float w2, glm::vec4 const *ring_colors, float const *ring_radii) {
+	glm::vec2 local = w0 * tri.local[0] + w1 * tri.local[1] + w2 * tri.local[2];
+	float d = glm::length(local);
+	//fwidth(d), from how local changes across a pixel:
+	float aa = 1e-6f;
+	if (d > 0.0f) {
+		aa = std::max(aa, (std::abs(glm::dot(local, tri.local_dx)) + std::abs(glm::dot(local, tri.local_dy))) / d);
+	}
+	glm::vec4 c = w0 * tri.color[0] + w1 * tri.color[1] + w2 * tri.color[2];
+	if (tri.rings.y > 0) {
+		c = ring_colors[tri.rings.x];
+		for (uint32_t k = 1; k < tri.rings.y; ++k) {
+			float t = glm::clamp((ring_radii[tri.rings.x + k] - d) / aa + 0.5f, 0.0f, 1.0f);
+			if (t == 0.0f) break;
+			c = glm::mix(c, ring_colors[tri.rings.x + k], t);
+		}
+	}
+	c.a *= glm::clamp((1.0f - d) / aa + 0.5f, 0.0f, 1.0f);
+	return c;
+}
+
+void SoftRasterizer::raster_tile(uint32_t tile) {
+	int32_t tile_x0 = int32_t((tile % tiles_x) * TileSize);
+	int32_t tile_y0 = int32_t((tile / tiles_x) * TileSize);
+	int32_t tile_x1 = std::min(tile_x0 + int32_t(TileSize), int32_t(size.x));
+	int32_t tile_y1 = std::min(tile_y0 + int32_t(TileSize), int32_t(size.y));
+	Texture const *texture = current_texture;
+	glm::vec4 const *ring_colors = current_ring_colors;
+	float const *ring_radii = current_ring_radii;
+
+	for (uint32_t index : tile_triangles[tile]) {
+		Triangle const &tri = triangles[index];
+		//spans start on multiples of 4 (tiles do too, so spans stay inside the tile):
+		int32_t x_begin = std::max(tri.min.x, tile_x0) & ~3;
+		int32_t x_end = std::min(tri.max.x + 1, tile_x1);
+		int32_t y_begin = std::max(tri.min.y, tile_y0);
+		int32_t y_end = std::min(tri.max.y + 1, tile_y1);
+
+#ifdef SOFT_RASTERIZER_SSE
+		__m128 const lane_centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 const lane_index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		__m128 normal_x[3], inclusive[3];
+		for (uint32_t e = 0; e < 3; ++e) {
+			normal_x[e] = _mm_set1_ps(tri.normal[e].x);
+			inclusive[e] = _mm_castsi128_ps(_mm_set1_epi32(tri.inclusive[e] ? -1 : 0));
+		}
+		__m128 const color0 = _mm_loadu_ps(&tri.color[0].x);
+		__m128 const color1 = _mm_loadu_ps(&tri.color[1].x);
+		__m128 const color2 = _mm_loadu_ps(&tri.color[2].x);
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const one = _mm_set1_ps(1.0f);
+		__m128 const to_unit = _mm_set1_ps(1.0f / 255.0f);
+		__m128 const to_byte = _mm_set1_ps(255.0f);
+#endif
+
+		for (int32_t y = y_begin; y < y_end; ++y) {
+			glm::u8vec4 *row = &pixels[size_t(y) * size.x];
+			float py = float(y) + 0.5f;
+			float edge_y[3]; //each edge's y contribution is constant along the row
+			for (uint32_t e = 0; e < 3; ++e) {
+				edge_y[e] = tri.normal[e].y * (py - tri.origin[e].y);
+			}
+
+			for (int32_t x = x_begin; x < x_end; x += 4) {
+				//edge values and coverage for pixels x .. x+3:
+				alignas(16) float edge[3][4];
+				uint32_t covered;
+#ifdef SOFT_RASTERIZER_SSE
+				__m128 inside = _mm_cmplt_ps(lane_index, _mm_set1_ps(float(x_end - x)));
+				for (uint32_t e = 0; e < 3; ++e) {
+					__m128 px = _mm_add_ps(_mm_set1_ps(float(x) - tri.origin[e].x), lane_centers);
+					__m128 value = _mm_add_ps(_mm_mul_ps(normal_x[e], px), _mm_set1_ps(edge_y[e]));
+					__m128 pass = _mm_or_ps(_mm_cmpgt_ps(value, zero), _mm_and_ps(_mm_cmpeq_ps(value, zero), inclusive[e]));
+					inside = _mm_and_ps(inside, pass);
+					_mm_store_ps(edge[e], value);
+				}
+				covered = uint32_t(_mm_movemask_ps(inside));
+#else
+				covered = 0;
+				for (uint32_t lane = 0; lane < 4; ++lane) {
+					bool pass = (x + int32_t(lane) < x_end);
+					for (uint32_t e = 0; e < 3; ++e) {
+						float value = tri.normal[e].x * (float(x) - tri.origin[e].x + float(lane) + 0.5f) + edge_y[e];
+						edge[e][lane] = value;
+						pass = pass && (value > 0.0f || (value == 0.0f && tri.inclusive[e]));
+					}
+					if (pass) covered |= (1U << lane);
+				}
+#endif
+				if (covered == 0) continue;
+
+				if (tri.opaque_flat) {
+					for (uint32_t lane = 0; lane < 4; ++lane) {
+						if (covered & (1U << lane)) row[x + lane] = tri.flat_color;
+					}
+					continue;
+				}
+
+				for (uint32_t lane = 0; lane < 4; ++lane) {
+					if (!(covered & (1U << lane))) continue;
+					glm::u8vec4 *pixel = row + x + lane;
+					float w0 = edge[0][lane] * tri.inv_area;
+					float w1 = edge[1][lane] * tri.inv_area;
+					float w2 = edge[2][lane] * tri.inv_area;
+					glm::vec4 tex = glm::vec4(1.0f);
+					if (texture) {
+						tex = sample(*texture, w0 * tri.tex_coord[0] + w1 * tri.tex_coord[1] + w2 * tri.tex_coord[2]);
+					}
+#ifdef SOFT_RASTERIZER_SSE
+					__m128 src;
+					if (tri.circle) {
+						glm::vec4 c = shade_circle(tri, w0, w1, w2, ring_colors, ring_radii);
+						src = _mm_loadu_ps(&c.x);
+					} else {
+						//fragColor = texture(TEX, texCoord) * color:
+						src = _mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(_mm_set1_ps(w0), color0),
+							_mm_mul_ps(_mm_set1_ps(w1), color1)),
+							_mm_mul_ps(_mm_set1_ps(w2), color2));
+						if (texture) src = _mm_mul_ps(src, _mm_loadu_ps(&tex.x));
+					}
+					//blend with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA (for all four channels):
+					int32_t dst_bits;
+					std::memcpy(&dst_bits, static_cast< void const * >(pixel), 4);
+					__m128i dst_i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(dst_bits), _mm_setzero_si128()), _mm_setzero_si128());
+					__m128 dst = _mm_mul_ps(_mm_cvtepi32_ps(dst_i), to_unit);
+					__m128 alpha = _mm_shuffle_ps(src, src, _MM_SHUFFLE(3, 3, 3, 3));
+					__m128 out = _mm_add_ps(_mm_mul_ps(src, alpha), _mm_mul_ps(dst, _mm_sub_ps(one, alpha)));
+					//back to bytes (rounding to nearest, clamping to 0-255):
+					__m128i out_i = _mm_cvtps_epi32(_mm_mul_ps(out, to_byte));
+					out_i = _mm_packus_epi16(_mm_packs_epi32(out_i, out_i), out_i);
+					int32_t out_bits = _mm_cvtsi128_si32(out_i);
+					std::memcpy(static_cast< void * >(pixel), &out_bits, 4);
+#else
+					glm::vec4 src;
+					if (tri.circle) src = shade_circle(tri, w0, w1, w2, ring_colors, ring_radii);
+					else src = (w0 * tri.color[0] + w1 * tri.color[1] + w2 * tri.color[2]) * tex;
+					glm::vec4 dst = glm::vec4(*pixel) / 255.0f;
+					glm::vec4 out = src * src.a + dst * (1.0f - src.a);
+					*pixel = glm::u8vec4(glm::clamp(glm::floor(out * 255.0f + 0.5f), 0.0f, 255.0f));
+#endif
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PongMode.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * SoftRasterizer draws PongMode's triangle lists on the CPU, following the same rules
+ *  as drawing them with ColorTextureProgram (or ColorProgram / CircleProgram, for compact vertices / circle quads) in OpenGL:
+ *   - positions are transformed by OBJECT_TO_CLIP and mapped to the whole framebuffer,
+ *   - a pixel is covered if its center is inside the triangle (top-left fill rule, either winding),
+ *   - fragment color is texture(TEX, texCoord) * color (bilinear, GL_REPEAT; atlas pages are padded, so clamping doesn't matter),
+ *   - fragments are blended with glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA),
+ *  so results can be compared against OpenGL screenshots (closely, not bit-for-bit:
+ *  edge and interpolation arithmetic is float and vertices are snapped to 1/256 pixel;
+ *  circle edges also use exact derivatives where GL takes differences over 2x2 pixel blocks).
+ *
+ * Triangles are binned into screen tiles, and tiles are rasterized in parallel by a pool
+ *  of threads; each tile draws its triangles in submission order, so blending matches.
+ * Coverage is tested four pixels at a time with SSE edge functions (scalar otherwise).
+ *
+ * Limitations: no clipping (triangles with any vertex at w <= 0 are skipped, and z is
+ *  ignored, as with GL_DEPTH_TEST disabled), and attributes are interpolated linearly
+ *  in screen space (exact for PongMode's orthographic world_to_clip).
+ */
+
+struct SoftRasterizer {
+	//thread_count = 0 uses one thread per hardware core:
+	SoftRasterizer(uint32_t thread_count = 0);
+	~SoftRasterizer();
+
+	SoftRasterizer(SoftRasterizer const &) = delete;
+	SoftRasterizer &operator=(SoftRasterizer const &) = delete;
+
+	struct Texture {
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > data; //rows start at the bottom (like glTexImage2D)
+	};
+
+	//(re)allocate the framebuffer:
+	void resize(glm::uvec2 const &size);
+	void clear(glm::u8vec4 const &color);
+	//draw triangles from 'count' indices into 'vertices' (like glDrawElements; indices == nullptr draws vertices 0 .. count-1 in order, like glDrawArrays);
+	// texture == nullptr means solid white (like PongMode's white_tex):
+	void draw(PongMode::Vertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip, Texture const *texture = nullptr);
+	//same, but untextured (like ColorProgram):
+	void draw_compact(PongMode::CompactVertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip);
+	//same, but CircleProgram-shaded; ring arrays are only needed if some vertices have rings:
+	void draw_circles(PongMode::CircleVertex const *vertices, uint32_t const *indices, size_t count, glm::mat4 const &object_to_clip, glm::vec4 const *ring_colors = nullptr, float const *ring_radii = nullptr);
+	//clear + draw a whole frame from PongMode::build_draw_list:
+	void render(PongMode::DrawList const &list);
+	//render()'s copy of the atlas pages (updated when the atlas's revision changes):
+	std::vector< Texture > atlas_pages;
+	uint32_t atlas_revision = 0;
+
+	glm::uvec2 size = glm::uvec2(0);
+	std::vector< glm::u8vec4 > pixels; //rows start at the bottom (pass LowerLeftOrigin to save_png)
+
+	//----- internals -----
+	static constexpr uint32_t TileSize = 64; //pixels (a multiple of 4, so 4-pixel spans never cross tiles)
+
+	//per-triangle setup, in window coordinates:
+	struct Triangle {
+		glm::vec2 origin[3]; //edge e is tested relative to origin[e]
+		glm::vec2 normal[3]; //edge e's value at p is dot(normal[e], p - origin[e]); inside is >= 0 (or > 0 for non-top-left edges)
+		bool inclusive[3]; //top-left edges include pixels exactly on them
+		float inv_area; //edge values * inv_area = barycentric weights
+		bool opaque_flat; //one fully-opaque color and no texture, so covered pixels are just overwritten
+		glm::u8vec4 flat_color; //the color, if opaque_flat
+		glm::vec4 color[3]; //0-1
+		glm::vec2 tex_coord[3];
+		bool circle; //shaded like CircleProgram (using local and rings) rather than texture * color
+		glm::vec2 local[3];
+		glm::vec2 local_dx, local_dy; //change in local per pixel step in x and y
+		glm::u8vec2 rings;
+		glm::ivec2 min, max; //covered pixel bounds (inclusive)
+	};
+	std::vector< Triangle > triangles;
+	uint32_t tiles_x = 0, tiles_y = 0;
+	std::vector< std::vector< uint32_t > > tile_triangles; //indices into 'triangles', in draw order
+	Texture const *current_texture = nullptr;
+	glm::vec4 const *current_ring_colors = nullptr;
+	float const *current_ring_radii = nullptr;
+
+	void begin_triangles(); //empty 'triangles' and the tile bins
+	//window-space edges and bounds for a triangle with these clip-space corners (attributes are left to the caller);
+	// 'order' gets which vertex became each corner, since clockwise triangles are flipped.
+	// returns false if nothing would be drawn:
+	bool setup_triangle(glm::vec4 const clip[3], Triangle *tri, uint32_t order[3]) const;
+	void bin_triangle(Triangle const &tri);
+
+	void raster_tile(uint32_t tile);
+	void run_tiles(); //raster every tile (on all threads) and wait
+
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable work_cv; //signalled when a new draw starts (or on shutdown)
+	std::condition_variable done_cv; //signalled when a worker runs out of tiles
+	uint64_t generation = 0; //incremented for every draw
+	uint32_t working = 0; //workers still busy with the current draw
+	bool quit = false;
+	std::atomic< uint32_t > next_tile{0};
+	void worker_main();
+};
@@ -0,0 +1,23 @@
+#include "SpriteBatch.hpp"
+
+#include <algorithm>
+
+void SpriteBatch::draw(TextureAtlas::Sprite const &sprite, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+	Quad quad;
+	quad.page = sprite.page;
+	quad.order = uint32_t(quads.size());
+	quad.min = center - radius;
+	quad.max = center + radius;
+	quad.min_uv = sprite.min_uv;
+	quad.max_uv = sprite.max_uv;
+	quad.color = color;
+	quads.emplace_back(quad);
+}
+
+void SpriteBatch::sort() {
+	//(std::stable_sort would want a scratch buffer from the heap; sorting on (page, order) gives the same result)
+	std::sort(quads.begin(), quads.end(), [](Quad const &a, Quad const &b) {
+		if (a.page != b.page) return a.page < b.page;
+		return a.order < b.order;
+	});
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "TextureAtlas.hpp"
+#include "FrameArena.hpp"
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+/*
+ * SpriteBatch collects a frame's sprites (rectangles textured with part of a TextureAtlas page)
+ *  so they can be drawn with one draw call per atlas page, rather than a bind and a draw per sprite.
+ *
+ * Call draw() in back-to-front order, then sort() once: sprites end up grouped by page, and
+ *  within each page stay in the order they were drawn. (So sprites on *different* pages don't
+ *  keep their relative order -- keep sprites that overlap on the same page.)
+ *
+ * Storage comes from a FrameArena, so batching doesn't touch the heap.
+ */
+
+struct SpriteBatch {
+	SpriteBatch(FrameArena &arena) : quads(arena) { }
+
+	struct Quad {
+		uint32_t page;
+		uint32_t order; //position in draw() order (keeps sort() stable without extra memory)
+		glm::vec2 min, max; //corners, in world space
+		glm::vec2 min_uv, max_uv;
+		glm::u8vec4 color; //multiplied with the texture
+	};
+	ArenaVector< Quad > quads;
+
+	//draw 'sprite' as a rectangle within 'radius' of 'center', tinted by 'color':
+	void draw(TextureAtlas::Sprite const &sprite, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color = glm::u8vec4(0xff));
+
+	//group quads by page (keeping drawing order within each page):
+	void sort();
+};
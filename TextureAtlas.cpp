@@ -0,0 +1,103 @@
+#include "TextureAtlas.hpp"
+
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+TextureAtlas::TextureAtlas(glm::uvec2 const &page_size_, uint32_t padding_) : page_size(page_size_), padding(padding_) {
+}
+
+uint32_t TextureAtlas::add(std::string const &name, glm::uvec2 const &size, std::vector< glm::u8vec4 > &&data) {
+	for (auto const &sprite : sprites) {
+		if (sprite.name == name) {
+			throw std::runtime_error("Texture atlas already has a sprite named '" + name + "'.");
+		}
+	}
+	if (size.x == 0 || size.y == 0) {
+		throw std::runtime_error("Sprite '" + name + "' is empty.");
+	}
+	if (data.size() != size_t(size.x) * size.y) {
+		throw std::runtime_error("Sprite '" + name + "' has " + std::to_string(data.size()) + " pixels, but is " + std::to_string(size.x) + "x" + std::to_string(size.y) + ".");
+	}
+	if (size.x + 2 * padding > page_size.x || size.y + 2 * padding > page_size.y) {
+		throw std::runtime_error("Sprite '" + name + "' (" + std::to_string(size.x) + "x" + std::to_string(size.y) + ") doesn't fit on a "
+			+ std::to_string(page_size.x) + "x" + std::to_string(page_size.y) + " atlas page.");
+	}
+	sprites.emplace_back();
+	sprites.back().name = name;
+	sprites.back().size = size;
+	sprites.back().data = std::move(data);
+	return uint32_t(sprites.size() - 1);
+}
+
+uint32_t TextureAtlas::load(std::string const &name, std::string const &filename) {
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > data;
+	load_png(filename, &size, &data, LowerLeftOrigin);
+	return add(name, size, std::move(data));
+}
+
+uint32_t TextureAtlas::find(std::string const &name) const {
+	for (uint32_t i = 0; i < sprites.size(); ++i) {
+		if (sprites[i].name == name) return i;
+	}
+	throw std::runtime_error("Texture atlas has no sprite named '" + name + "'.");
+}
+
+void TextureAtlas::pack() {
+	pages.clear();
+
+	//tallest first (then widest), so each shelf is mostly filled by sprites close to its height:
+	std::vector< uint32_t > order(sprites.size());
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+		if (sprites[a].size.y != sprites[b].size.y) return sprites[a].size.y > sprites[b].size.y;
+		if (sprites[a].size.x != sprites[b].size.x) return sprites[a].size.x > sprites[b].size.x;
+		return a < b;
+	});
+
+	//the shelf being filled on the last page:
+	glm::uvec2 cursor = glm::uvec2(0); //where the next sprite's (padded) cell goes
+	uint32_t shelf_height = 0; //height of the current shelf (0 = no shelf yet)
+
+	for (uint32_t index : order) {
+		Sprite &sprite = sprites[index];
+		glm::uvec2 cell = sprite.size + glm::uvec2(2 * padding);
+
+		//start a new shelf if the sprite doesn't fit at the end of this one:
+		if (shelf_height != 0 && cursor.x + cell.x > page_size.x) {
+			cursor = glm::uvec2(0, cursor.y + shelf_height);
+			shelf_height = 0;
+		}
+		//start a new page if the shelf doesn't fit on this one:
+		if (pages.empty() || cursor.y + cell.y > page_size.y) {
+			pages.emplace_back(size_t(page_size.x) * page_size.y, glm::u8vec4(0x00));
+			cursor = glm::uvec2(0);
+			shelf_height = 0;
+		}
+		if (shelf_height == 0) shelf_height = cell.y;
+
+		sprite.page = uint32_t(pages.size() - 1);
+		sprite.at = cursor + glm::uvec2(padding);
+		sprite.min_uv = glm::vec2(sprite.at) / glm::vec2(page_size);
+		sprite.max_uv = glm::vec2(sprite.at + sprite.size) / glm::vec2(page_size);
+		cursor.x += cell.x;
+
+		//copy the image, extending its edge pixels out through the padding:
+		std::vector< glm::u8vec4 > &page = pages.back();
+		glm::ivec2 size = glm::ivec2(sprite.size);
+		for (int32_t y = -int32_t(padding); y < size.y + int32_t(padding); ++y) {
+			int32_t from_y = std::min(std::max(y, 0), size.y - 1);
+			glm::u8vec4 *row = page.data() + size_t(sprite.at.y + y) * page_size.x + sprite.at.x;
+			glm::u8vec4 const *from_row = sprite.data.data() + size_t(from_y) * size.x;
+			for (int32_t x = -int32_t(padding); x < size.x + int32_t(padding); ++x) {
+				row[x] = from_row[std::min(std::max(x, 0), size.x - 1)];
+			}
+		}
+	}
+
+	revision += 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * TextureAtlas packs many small images ("sprites") into a few large images ("pages"),
+ *  so sprites that share a page can be drawn with one texture bind and one draw call
+ *  (see SpriteBatch.hpp).
+ *
+ * Sprites are added at load time with add() / load() (which uses load_png), then pack()
+ *  places all of them at once with shelf packing: tallest first, left to right along
+ *  rows ("shelves") as tall as their first sprite, starting a new shelf when a row is full
+ *  and a new page when a page is full.
+ *
+ * Each sprite is surrounded by 'padding' pixels copied from its own edges, so bilinear
+ *  filtering never picks up a neighbor's pixels.
+ *
+ * The atlas itself doesn't touch OpenGL; PongMode::draw() uploads the pages whenever
+ *  'revision' changes.
+ */
+
+struct TextureAtlas {
+	TextureAtlas(glm::uvec2 const &page_size = glm::uvec2(1024, 1024), uint32_t padding = 1);
+
+	struct Sprite {
+		std::string name;
+		glm::uvec2 size = glm::uvec2(0); //pixels
+		std::vector< glm::u8vec4 > data; //rows start at the bottom (kept, so pack() can run again after more sprites are added)
+		//placement, filled in by pack():
+		uint32_t page = 0;
+		glm::uvec2 at = glm::uvec2(0); //lower-left corner of the image on the page (inside the padding)
+		glm::vec2 min_uv = glm::vec2(0.0f), max_uv = glm::vec2(0.0f); //texture coordinates of the image's corners
+	};
+
+	//add a sprite; returns its index in 'sprites'.
+	//NOTE: add and load throw on error (duplicate name, or sprite too large to fit on a page)
+	uint32_t add(std::string const &name, glm::uvec2 const &size, std::vector< glm::u8vec4 > &&data);
+	//add a sprite from a PNG file:
+	uint32_t load(std::string const &name, std::string const &filename);
+	//index of a sprite by name (throws if there isn't one):
+	uint32_t find(std::string const &name) const;
+
+	//place every sprite added so far (re-packing any already placed) and rebuild the pages:
+	void pack();
+
+	glm::uvec2 page_size;
+	uint32_t padding;
+	std::vector< Sprite > sprites;
+	std::vector< std::vector< glm::u8vec4 > > pages; //page_size.x * page_size.y pixels each, rows start at the bottom
+	uint32_t revision = 0; //incremented by pack()
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/*
+ * TripleBuffer hands values from one writer thread to one reader thread without locks.
+ * The writer fills write_buffer() and calls publish(); the reader calls fetch() and then
+ *  uses read_buffer(), which stays untouched by the writer until the next fetch().
+ * Neither side ever waits: the writer overwrites values the reader never picked up.
+ */
+
+template< typename T >
+struct TripleBuffer {
+	//----- writer side -----
+	T &write_buffer() { return slots[write_index]; }
+	void publish() {
+		write_index = middle.exchange(uint8_t(write_index | Fresh), std::memory_order_acq_rel) & IndexMask;
+	}
+
+	//----- reader side -----
+	//returns true if a newer value was published since the last fetch:
+	bool fetch() {
+		if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+		read_index = middle.exchange(read_index, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+	T const &read_buffer() const { return slots[read_index]; }
+
+	//----- internals -----
+	enum : uint8_t { IndexMask = 0x3, Fresh = 0x4 };
+	T slots[3];
+	uint8_t write_index = 0; //only touched by writer
+	std::atomic< uint8_t > middle{1}; //slot between the two sides (+ Fresh bit if it holds an unread value)
+	uint8_t read_index = 2; //only touched by reader
+};
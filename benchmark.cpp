@@ -0,0 +1,333 @@
+//Benchmarks for PongMode's hot paths: update() (simulation steps) and build_draw_list() (vertex generation),
+// plus drawing those vertices with SoftRasterizer, and PongBatch stepping many games across thread counts.
+// Runs without a window or OpenGL context.
+//
+// usage: pongoria-bench [--iterations <n>] [--balls <n>] [--games <n>] [--filter <text>] [--json <file>]
+//  prints tables to stdout; --json also writes the results as JSON (for tracking regressions).
+//  (allocation counts are only measured in builds without NDEBUG; see AllocationCounter.hpp)
+
+#include "PongMode.hpp"
+#include "PongBatch.hpp"
+#include "AllocationCounter.hpp"
+#include "SoftRasterizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Scenario {
+	std::string name;
+	//put a freshly-constructed mode into the state to measure:
+	std::function< void(PongMode &) > setup;
+};
+
+struct Result {
+	std::string scenario;
+	std::string phase; //"update", "draw", or "raster"
+	uint32_t iterations = 0;
+	double ns_per_op = 0.0;
+	double allocations_per_op = 0.0;
+	size_t vertices = 0; //draw/raster only: vertices (of all kinds) in the last frame
+};
+
+//PongBatch throughput at one thread count:
+struct BatchResult {
+	size_t games = 0;
+	uint32_t threads = 0;
+	uint32_t steps = 0;
+	double games_per_second = 0.0; //game-steps simulated per second
+};
+
+static const float Step = 1.0f / 60.0f;
+static const glm::uvec2 DrawableSize = glm::uvec2(1280, 720);
+
+//paddles follow the ball (court-space mouse position is relative to the camera, which follows the ball):
+static void follow_ball(PongMode &pong) {
+	pong.absolute_mouse_pos = glm::vec2(0.0f);
+}
+
+//scenarios name a state, but the game moves on from it (bricks break, the ball leaves the POI, ...),
+// so update() is timed in short runs, each from a freshly set-up mode (made outside the timed region):
+static const uint32_t StepsPerRun = 60; //one second of game time
+static const uint32_t WarmUpSteps = 5; //untimed steps at the start of each run, so containers have grown
+
+static Result bench_update(Scenario const &scenario, uint32_t iterations) {
+	const char *title = "";
+	Mode::Window_settings window_settings = Mode::Window_settings(glm::uvec2(800, 800), glm::uvec2(0, 0), 1.0f, &title);
+
+	double ns = 0.0;
+	uint64_t allocations = 0;
+	for (uint32_t done = 0; done < iterations; ) {
+		std::unique_ptr< PongMode > pong(new PongMode(false));
+		scenario.setup(*pong);
+		for (uint32_t i = 0; i < WarmUpSteps; ++i) {
+			follow_ball(*pong);
+			pong->update(Step, window_settings);
+		}
+
+		uint32_t steps = std::min(StepsPerRun, iterations - done);
+		uint64_t allocations_before = heap_allocation_count();
+		auto before = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < steps; ++i) {
+			follow_ball(*pong);
+			pong->update(Step, window_settings);
+		}
+		auto after = std::chrono::steady_clock::now();
+		ns += std::chrono::duration< double, std::nano >(after - before).count();
+		allocations += heap_allocation_count() - allocations_before;
+		done += steps;
+	}
+
+	Result result;
+	result.scenario = scenario.name;
+	result.phase = "update";
+	result.iterations = iterations;
+	result.ns_per_op = ns / iterations;
+	result.allocations_per_op = double(allocations) / iterations;
+	return result;
+}
+
+static Result bench_draw(Scenario const &scenario, uint32_t iterations) {
+	std::unique_ptr< PongMode > pong(new PongMode(false));
+	scenario.setup(*pong);
+
+	//warm up (sizes the frame arena and vertex_count_hint):
+	size_t vertices = 0;
+	for (uint32_t i = 0; i < 10; ++i) {
+		pong->frame_arena.reset();
+		PongMode::DrawList list(pong->frame_arena);
+		pong->build_draw_list(DrawableSize, 1.0f, &list);
+	}
+
+	uint64_t allocations_before = heap_allocation_count();
+	auto before = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i) {
+		pong->frame_arena.reset();
+		PongMode::DrawList list(pong->frame_arena);
+		pong->build_draw_list(DrawableSize, 1.0f, &list);
+		vertices = list.vertices.size() + list.compact_vertices.size() + list.circle_vertices.size();
+	}
+	auto after = std::chrono::steady_clock::now();
+
+	Result result;
+	result.scenario = scenario.name;
+	result.phase = "draw";
+	result.iterations = iterations;
+	result.ns_per_op = std::chrono::duration< double, std::nano >(after - before).count() / iterations;
+	result.allocations_per_op = double(heap_allocation_count() - allocations_before) / iterations;
+	result.vertices = vertices;
+	return result;
+}
+
+//SoftRasterizer drawing one frame's vertices (built once, outside the timing):
+static Result bench_raster(Scenario const &scenario, uint32_t iterations, SoftRasterizer &raster) {
+	std::unique_ptr< PongMode > pong(new PongMode(false));
+	scenario.setup(*pong);
+	PongMode::DrawList list(pong->frame_arena);
+	pong->build_draw_list(DrawableSize, 1.0f, &list);
+
+	raster.render(list); //warm up (sizes bins)
+
+	uint64_t allocations_before = heap_allocation_count();
+	auto before = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < iterations; ++i) {
+		raster.render(list);
+	}
+	auto after = std::chrono::steady_clock::now();
+
+	Result result;
+	result.scenario = scenario.name;
+	result.phase = "raster";
+	result.iterations = iterations;
+	result.ns_per_op = std::chrono::duration< double, std::nano >(after - before).count() / iterations;
+	result.allocations_per_op = double(heap_allocation_count() - allocations_before) / iterations;
+	result.vertices = list.vertices.size() + list.compact_vertices.size() + list.circle_vertices.size();
+	return result;
+}
+
+//PongBatch stepping 'games' games (paddles following each game's ball) on 'threads' threads:
+static BatchResult bench_batch(size_t games, uint32_t threads, uint32_t steps) {
+	//(like bench_update, the batch is made and warmed up outside the timed region)
+	PongBatch batch(games, threads);
+	std::vector< glm::vec2 > actions(games);
+	auto follow_balls = [&]() {
+		for (size_t g = 0; g < games; ++g) {
+			actions[g] = glm::vec2(batch.ball_x[g], batch.ball_y[g]);
+		}
+	};
+	for (uint32_t i = 0; i < WarmUpSteps; ++i) {
+		follow_balls();
+		batch.step(Step, actions.data());
+	}
+
+	auto before = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < steps; ++i) {
+		follow_balls();
+		batch.step(Step, actions.data());
+	}
+	auto after = std::chrono::steady_clock::now();
+
+	BatchResult result;
+	result.games = games;
+	result.threads = batch.partitions;
+	result.steps = steps;
+	result.games_per_second = double(games) * steps / std::chrono::duration< double >(after - before).count();
+	return result;
+}
+
+static void write_json(std::ostream &out, std::vector< Result > const &results, std::vector< BatchResult > const &batch_results, uint32_t balls) {
+	out << "{\n";
+	out << "\t\"step\": " << Step << ",\n";
+	out << "\t\"drawable_size\": [" << DrawableSize.x << ", " << DrawableSize.y << "],\n";
+	out << "\t\"balls\": " << balls << ",\n";
+	out << "\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		Result const &r = results[i];
+		out << "\t\t{ \"scenario\": \"" << r.scenario << "\", \"phase\": \"" << r.phase << "\""
+			<< ", \"iterations\": " << r.iterations
+			<< ", \"ns_per_op\": " << r.ns_per_op
+			<< ", \"allocations_per_op\": " << r.allocations_per_op;
+		if (r.phase != "update") out << ", \"vertices\": " << r.vertices;
+		out << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "\t],\n";
+	out << "\t\"batch\": [\n";
+	for (size_t i = 0; i < batch_results.size(); ++i) {
+		BatchResult const &r = batch_results[i];
+		out << "\t\t{ \"games\": " << r.games << ", \"threads\": " << r.threads << ", \"steps\": " << r.steps
+			<< ", \"games_per_second\": " << r.games_per_second
+			<< " }" << (i + 1 < batch_results.size() ? "," : "") << "\n";
+	}
+	out << "\t]\n";
+	out << "}\n";
+}
+
+int main(int argc, char **argv) {
+	uint32_t iterations = 2000;
+	uint32_t balls = 1000;
+	size_t games = 4096;
+	std::string filter = "";
+	std::string json_filename = "";
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--iterations" && i + 1 < argc) {
+			iterations = uint32_t(std::max(1, std::atoi(argv[++i])));
+		} else if (arg == "--balls" && i + 1 < argc) {
+			balls = uint32_t(std::max(0, std::atoi(argv[++i])));
+		} else if (arg == "--games" && i + 1 < argc) {
+			games = size_t(std::max(0, std::atoi(argv[++i])));
+		} else if (arg == "--filter" && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (arg == "--json" && i + 1 < argc) {
+			json_filename = argv[++i];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--iterations <n>] [--balls <n>] [--games <n>] [--filter <text>] [--json <file>]" << std::endl;
+			return 1;
+		}
+	}
+
+	auto main_area = [](PongMode &pong) {
+		pong.starting_area = false;
+		pong.ball = glm::vec2(0.0f, 0.0f);
+		pong.restart_trail();
+	};
+
+	std::vector< Scenario > scenarios;
+	scenarios.push_back(Scenario{"starting_area", [](PongMode &) { }});
+	scenarios.push_back(Scenario{"main_all_bricks", main_area});
+	scenarios.push_back(Scenario{"flipped", [main_area](PongMode &pong) {
+		main_area(pong);
+		pong.state_flipped = true;
+	}});
+	scenarios.push_back(Scenario{"rainbow_poi", [main_area](PongMode &pong) {
+		main_area(pong);
+		pong.state_rainbow = true;
+		//near the rainbow POI (with it in view), heading away from it:
+		pong.ball = glm::vec2(0.0f, -13.0f);
+		pong.ball_velocity = glm::vec2(0.0f, 1.0f);
+		pong.camera_pos = pong.camera_prev = pong.ball;
+		pong.restart_trail();
+	}});
+	scenarios.push_back(Scenario{"long_trail", [main_area](PongMode &pong) {
+		main_area(pong);
+		//a trail ten times longer, sampled up to 1000 times a second:
+		pong.trail_length *= 10.0f;
+		pong.ball_trail = BallTrail(pong.trail_length, 1000.0f);
+		pong.restart_trail();
+		const char *title = "";
+		Mode::Window_settings window_settings = Mode::Window_settings(glm::uvec2(800, 800), glm::uvec2(0, 0), 1.0f, &title);
+		for (uint32_t i = 0; i < uint32_t(pong.trail_length * 1000.0f); ++i) {
+			follow_ball(pong);
+			pong.update(0.001f, window_settings);
+		}
+	}});
+	if (balls != 0) {
+		scenarios.push_back(Scenario{"balls_" + std::to_string(balls), [main_area, balls](PongMode &pong) {
+			main_area(pong);
+			pong.extra_ball_count = balls;
+			pong.spawn_extra_balls();
+		}});
+	}
+
+	SoftRasterizer raster;
+	raster.resize(DrawableSize);
+	//(rasterizing takes about a hundred times longer than building the vertices; keep its total time comparable)
+	uint32_t raster_iterations = std::max(1U, iterations / 100);
+
+	std::vector< Result > results;
+	std::cout << std::left << std::setw(20) << "scenario" << std::setw(8) << "phase"
+		<< std::right << std::setw(14) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(10) << "vertices" << std::endl;
+	for (auto const &scenario : scenarios) {
+		if (filter != "" && scenario.name.find(filter) == std::string::npos) continue;
+		for (Result const &r : { bench_update(scenario, iterations), bench_draw(scenario, iterations), bench_raster(scenario, raster_iterations, raster) }) {
+			std::cout << std::left << std::setw(20) << r.scenario << std::setw(8) << r.phase
+				<< std::right << std::setw(14) << std::fixed << std::setprecision(1) << r.ns_per_op
+				<< std::setw(12) << std::setprecision(2) << r.allocations_per_op
+				<< std::setw(10) << (r.phase != "update" ? std::to_string(r.vertices) : std::string("-")) << std::endl;
+			results.emplace_back(r);
+		}
+	}
+
+	//PongBatch scaling: 1, 2, 4, ... threads, up to one per hardware core:
+	std::vector< BatchResult > batch_results;
+	std::string batch_name = "batch_" + std::to_string(games);
+	if (games != 0 && (filter == "" || batch_name.find(filter) != std::string::npos)) {
+		uint32_t cores = std::max(1U, std::thread::hardware_concurrency());
+		std::vector< uint32_t > thread_counts;
+		for (uint32_t threads = 1; threads < cores; threads *= 2) {
+			thread_counts.emplace_back(threads);
+		}
+		thread_counts.emplace_back(cores);
+		//(a batch step is about 'games' updates; keep the total time comparable to the table above)
+		uint32_t steps = std::max(1U, uint32_t(uint64_t(iterations) * 100 / games));
+
+		std::cout << "\n" << std::left << std::setw(20) << "scenario" << std::setw(8) << "threads"
+			<< std::right << std::setw(14) << "games/s" << std::setw(12) << "speedup" << std::endl;
+		for (uint32_t threads : thread_counts) {
+			BatchResult r = bench_batch(games, threads, steps);
+			std::cout << std::left << std::setw(20) << batch_name << std::setw(8) << r.threads
+				<< std::right << std::setw(14) << std::fixed << std::setprecision(0) << r.games_per_second
+				<< std::setw(12) << std::setprecision(2) << (r.games_per_second / (batch_results.empty() ? r.games_per_second : batch_results[0].games_per_second)) << std::endl;
+			batch_results.emplace_back(r);
+		}
+	}
+
+	if (json_filename != "") {
+		std::ofstream json(json_filename.c_str());
+		if (!json) {
+			std::cerr << "Failed to open '" << json_filename << "' for writing." << std::endl;
+			return 1;
+		}
+		write_json(json, results, batch_results, balls);
+		std::cout << "Wrote results to '" << json_filename << "'." << std::endl;
+	}
+	return 0;
+}
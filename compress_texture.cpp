@@ -0,0 +1,88 @@
+//Offline texture compression: converts a PNG (and its mipmaps) to a block-compressed .ctex file
+// that CompressedTexture::load() + upload() hand straight to glCompressedTexImage2D.
+//
+// usage: pongoria-compress <input.png> <output.ctex> [--format bc1|bc3|bc4|bc5] [--no-mips]
+//  --format   bc1 (default): RGB + 1-bit alpha; bc3: RGBA; bc4: red only; bc5: red + green
+//  --no-mips  store only the full-size image
+// prints the size before and after, and the error in the largest level.
+
+#include "CompressedTexture.hpp"
+#include "MipChain.hpp"
+#include "load_save_png.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void usage(char const *name) {
+	std::cerr << "Usage:\n\t" << name << " <input.png> <output.ctex> [--format bc1|bc3|bc4|bc5] [--no-mips]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string input = argv[1];
+	std::string output = argv[2];
+	CompressedTexture::Format format = CompressedTexture::BC1;
+	bool mips = true;
+	for (int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--format" && i + 1 < argc) {
+			std::string name = argv[++i];
+			if (name == "bc1") format = CompressedTexture::BC1;
+			else if (name == "bc3") format = CompressedTexture::BC3;
+			else if (name == "bc4") format = CompressedTexture::BC4;
+			else if (name == "bc5") format = CompressedTexture::BC5;
+			else {
+				std::cerr << "Unknown format '" << name << "' (expecting bc1, bc3, bc4, or bc5)." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--no-mips") {
+			mips = false;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	try {
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > data;
+		load_png(input, &size, &data, LowerLeftOrigin);
+		MipChain chain(size, std::move(data));
+		if (mips) chain.build();
+
+		CompressedTexture texture;
+		texture.encode(chain, format);
+		texture.save(output);
+
+		size_t raw_bytes = 0, compressed_bytes = 0;
+		for (uint32_t level = 0; level < chain.levels.size(); ++level) {
+			raw_bytes += chain.levels[level].size() * sizeof(glm::u8vec4);
+			compressed_bytes += texture.levels[level].size();
+		}
+
+		//root-mean-square error (per channel that the format stores) in the largest level:
+		std::vector< glm::u8vec4 > decoded;
+		texture.decode(0, &decoded);
+		uint32_t channels = (format == CompressedTexture::BC4 ? 1 : (format == CompressedTexture::BC5 ? 2 : (format == CompressedTexture::BC1 ? 3 : 4)));
+		double error = 0.0;
+		for (size_t i = 0; i < decoded.size(); ++i) {
+			for (uint32_t c = 0; c < channels; ++c) {
+				double d = double(decoded[i][c]) - double(chain.levels[0][i][c]);
+				error += d * d;
+			}
+		}
+		error = std::sqrt(error / double(decoded.size() * channels));
+
+		std::cout << input << " (" << size.x << "x" << size.y << ", " << chain.levels.size() << " level" << (chain.levels.size() == 1 ? "" : "s") << "): "
+			<< raw_bytes << " bytes -> " << compressed_bytes << " bytes in '" << output << "'; RMS error " << error << std::endl;
+	} catch (std::exception const &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
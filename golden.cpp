@@ -0,0 +1,238 @@
+//Golden-image checks for PongMode's rendering.
+// Replays a recorded session (see InputRecording.hpp), renders offscreen at fixed times, and compares
+// each frame against a stored PNG with a tolerant perceptual diff (see ImageDiff.hpp).
+//
+// usage: pongoria-golden <recording> <golden directory> [options]
+//  --update               write the rendered frames as the new golden images instead of comparing
+//  --every <seconds>      capture a frame every this many seconds of game time (default 1)
+//  --at <t1,t2,...>       capture at exactly these times instead
+//  --size <w>x<h>         framebuffer size (default 800x800)
+//  --threshold <0-1>      largest perceptual distance a pixel may be off by and still match (default 0.1)
+//  --max-different <n>    number of pixels allowed past the threshold (default 8, for stray edge pixels)
+//  --balls <n>            fail unless the recording was made with <n> extra balls (the count itself comes from the recording)
+//  --gl                   render with OpenGL (HeadlessGL) instead of SoftRasterizer
+//  --out <directory>      where to write <name>.actual.png and <name>.diff.png for failures (default: golden directory)
+// exits with 1 if any frame fails (or is missing), so it can gate CI.
+// (directories must already exist)
+
+#include "PongMode.hpp"
+#include "InputRecording.hpp"
+#include "HeadlessGL.hpp"
+#include "SoftRasterizer.hpp"
+#include "ImageDiff.hpp"
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void usage(char const *name) {
+	std::cerr << "Usage:\n\t" << name << " <recording> <golden directory> [--update] [--every <seconds>] [--at <t1,t2,...>] [--size <w>x<h>]"
+		" [--threshold <0-1>] [--max-different <n>] [--balls <n>] [--gl] [--out <directory>]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string recording_filename = argv[1];
+	std::string golden_dir = argv[2];
+	std::string out_dir = "";
+	bool update = false;
+	float every = 1.0f;
+	std::vector< float > at;
+	glm::uvec2 size = glm::uvec2(800, 800);
+	float threshold = 0.1f;
+	size_t max_different = 8;
+	uint32_t extra_balls = 0;
+	bool balls_given = false;
+	bool use_gl = false;
+	for (int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--update") {
+			update = true;
+		} else if (arg == "--every" && i + 1 < argc) {
+			every = float(std::atof(argv[++i]));
+			if (!(every > 0.0f)) {
+				std::cerr << "--every expects a positive number of seconds." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--at" && i + 1 < argc) {
+			std::istringstream list(argv[++i]);
+			std::string item;
+			while (std::getline(list, item, ',')) {
+				at.emplace_back(float(std::atof(item.c_str())));
+			}
+			std::sort(at.begin(), at.end());
+		} else if (arg == "--size" && i + 1 < argc) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++i], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "--size expects a size like 800x600." << std::endl;
+				return 1;
+			}
+			size = glm::uvec2(w, h);
+		} else if (arg == "--threshold" && i + 1 < argc) {
+			threshold = float(std::atof(argv[++i]));
+		} else if (arg == "--max-different" && i + 1 < argc) {
+			max_different = size_t(std::max(0, std::atoi(argv[++i])));
+		} else if (arg == "--balls" && i + 1 < argc) {
+			extra_balls = uint32_t(std::max(0, std::atoi(argv[++i])));
+			balls_given = true;
+		} else if (arg == "--gl") {
+			use_gl = true;
+		} else if (arg == "--out" && i + 1 < argc) {
+			out_dir = argv[++i];
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (out_dir == "") out_dir = golden_dir;
+
+	InputRecording recording;
+	try {
+		recording.load(recording_filename);
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to load recording: " << e.what() << std::endl;
+		return 1;
+	}
+	if (balls_given && extra_balls != recording.extra_ball_count) {
+		std::cerr << "--balls " << extra_balls << " doesn't match the " << recording.extra_ball_count << " extra balls '" << recording_filename << "' was recorded with." << std::endl;
+		return 1;
+	}
+	extra_balls = recording.extra_ball_count;
+
+	//capture times (seconds of game time):
+	if (at.empty()) {
+		double total = 0.0;
+		for (auto const &frame : recording.frames) total += frame.elapsed;
+		for (uint32_t k = 1; k * double(every) <= total; ++k) {
+			at.emplace_back(k * every);
+		}
+	}
+	if (at.empty()) {
+		std::cerr << "Nothing to capture (recording '" << recording_filename << "' is too short)." << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr< HeadlessGL > headless;
+	std::unique_ptr< SoftRasterizer > soft;
+	if (use_gl) {
+		headless.reset(new HeadlessGL(size));
+		headless->bind();
+	} else {
+		soft.reset(new SoftRasterizer());
+		soft->resize(size);
+	}
+
+	uint32_t failed = 0, passed = 0, written = 0;
+	{ //(PongMode's GL resources need to go before the context does)
+		PongMode pong(use_gl);
+		pong.extra_ball_count = extra_balls;
+		const char *title = "";
+		Mode::Window_settings window_settings = Mode::Window_settings(size, glm::uvec2(0, 0), 1.0f, &title);
+
+		//drawing consumes random numbers (e.g., POI shapes), so every capture starts from the same state:
+		PCG32 const draw_rng = pong.draw_rng;
+
+		std::vector< glm::u8vec4 > pixels;
+		auto render = [&]() {
+			pong.draw_rng = draw_rng;
+			pong.frame_arena.reset();
+			if (soft) {
+				PongMode::DrawList list(pong.frame_arena);
+				pong.build_draw_list(size, 1.0f, &list);
+				soft->render(list);
+				pixels = soft->pixels;
+			} else {
+				pong.draw(size, 1.0f);
+				headless->read_pixels(&pixels);
+			}
+			for (auto &px : pixels) {
+				px.a = 0xff;
+			}
+		};
+
+		auto capture = [&](float time) {
+			char name[32];
+			std::snprintf(name, sizeof(name), "t%07u", uint32_t(std::round(time * 1000.0f)));
+			std::string golden_path = golden_dir + "/" + name + ".png";
+			render();
+
+			if (update) {
+				save_png(golden_path, size, pixels.data(), LowerLeftOrigin);
+				written += 1;
+				std::cout << name << ": wrote '" << golden_path << "'." << std::endl;
+				return;
+			}
+
+			glm::uvec2 golden_size;
+			std::vector< glm::u8vec4 > golden;
+			try {
+				load_png(golden_path, &golden_size, &golden, LowerLeftOrigin);
+			} catch (std::exception const &e) {
+				std::cout << name << ": FAILED (" << e.what() << " Run with --update to create it.)" << std::endl;
+				failed += 1;
+				return;
+			}
+			if (golden_size != size) {
+				std::cout << name << ": FAILED (golden image is " << golden_size.x << "x" << golden_size.y << ", rendered " << size.x << "x" << size.y << ")" << std::endl;
+				failed += 1;
+				return;
+			}
+
+			std::vector< glm::u8vec4 > diff;
+			ImageDiffResult result = diff_images(pixels.size(), golden.data(), pixels.data(), threshold, &diff);
+			if (result.different > max_different) {
+				std::string actual_path = out_dir + "/" + name + ".actual.png";
+				std::string diff_path = out_dir + "/" + name + ".diff.png";
+				save_png(actual_path, size, pixels.data(), LowerLeftOrigin);
+				save_png(diff_path, size, diff.data(), LowerLeftOrigin);
+				std::cout << name << ": FAILED (" << result.different << " pixels differ, max distance " << result.max_delta
+					<< "; wrote '" << actual_path << "' and '" << diff_path << "')" << std::endl;
+				failed += 1;
+			} else {
+				std::cout << name << ": ok";
+				if (result.similar + result.different != 0) {
+					std::cout << " (" << result.similar << " pixels within tolerance, " << result.different << " beyond; max distance " << result.max_delta << ")";
+				}
+				std::cout << std::endl;
+				passed += 1;
+			}
+		};
+
+		double time = 0.0;
+		size_t next = 0;
+		for (auto const &frame : recording.frames) {
+			if (next == at.size()) break;
+			pong.absolute_mouse_pos = frame.mouse;
+			pong.rng.seed(frame.seed);
+			pong.frame_arena.reset();
+			pong.update(frame.elapsed, window_settings);
+			time += frame.elapsed;
+			//capture at the first frame at or after each time:
+			while (next < at.size() && at[next] <= time + 1e-6) {
+				capture(at[next]);
+				next += 1;
+			}
+		}
+		for (; next < at.size(); ++next) {
+			std::cout << "Recording ends before t = " << at[next] << "s; not captured." << std::endl;
+			failed += 1;
+		}
+	}
+
+	if (update) {
+		std::cout << "Wrote " << written << " golden images to '" << golden_dir << "'." << std::endl;
+		return failed ? 1 : 0;
+	}
+	std::cout << passed << " passed, " << failed << " failed." << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+//Stand-in client for the shared-memory gym interface (see GymShm.hpp).
+// Connects to a running 'Pongoria --gym <name>', plays with a trivial "follow the ball" policy,
+// and reports round-trip step latency.
+//
+// usage: gym-client <name> [steps]
+
+#include "GymShm.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage:\n\t" << argv[0] << " <name> [steps]" << std::endl;
+		return 1;
+	}
+	std::string shm_name = std::string("/") + argv[1];
+	uint32_t steps = (argc == 3 ? uint32_t(std::atoi(argv[2])) : 100000);
+
+	//connect, giving the server a few seconds to start up:
+	int fd = -1;
+	for (uint32_t attempt = 0; attempt < 50 && fd < 0; ++attempt) {
+		fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+		if (fd < 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	if (fd < 0) {
+		std::cerr << "Failed to open shared memory '" << shm_name << "': " << strerror(errno) << std::endl;
+		return 1;
+	}
+	void *mapping = mmap(nullptr, sizeof(GymShared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		std::cerr << "Failed to map shared memory '" << shm_name << "': " << strerror(errno) << std::endl;
+		return 1;
+	}
+	GymShared *shared = reinterpret_cast< GymShared * >(mapping);
+	while (shared->magic != GymShared::Magic) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (shared->version != GymShared::Version) {
+		std::cerr << "Server speaks version " << shared->version << ", expected " << GymShared::Version << "." << std::endl;
+		return 1;
+	}
+	shared->client_pid.store(uint32_t(getpid()), std::memory_order_release);
+
+	uint32_t sent = shared->actions_written.load();
+	//send one action and wait for its observation (returns false if the server went away):
+	auto round_trip = [&](GymAction const &action, GymObservation *obs) -> bool {
+		shared->actions[sent % GymShared::RingSize] = action;
+		sent += 1;
+		gym_publish(shared->actions_written, sent);
+		uint32_t seen = shared->observations_written.load(std::memory_order_acquire);
+		while (seen != sent) {
+			if (!gym_wait_change(shared->observations_written, seen, shared->server_pid, &seen)) {
+				std::cerr << "Gym server (pid " << shared->server_pid.load() << ") exited while waiting for step " << sent << "." << std::endl;
+				return false;
+			}
+		}
+		*obs = shared->observations[(sent - 1) % GymShared::RingSize];
+		return true;
+	};
+
+	GymAction action;
+	action.command = GymAction::Reset;
+	action.elapsed = 0.0f;
+	action.target[0] = action.target[1] = 0.0f;
+	GymObservation obs;
+	if (!round_trip(action, &obs)) {
+		munmap(mapping, sizeof(GymShared));
+		return 1;
+	}
+
+	std::vector< float > latencies_us;
+	latencies_us.reserve(steps);
+	uint32_t resets = 0;
+	for (uint32_t s = 0; s < steps; ++s) {
+		if (obs.area == 2) {
+			action.command = GymAction::Reset;
+			resets += 1;
+		} else {
+			//policy: put the paddles wherever the ball is:
+			action.command = GymAction::Step;
+			action.elapsed = 1.0f / 60.0f;
+			action.target[0] = obs.ball[0];
+			action.target[1] = obs.ball[1];
+		}
+		auto before = std::chrono::steady_clock::now();
+		if (!round_trip(action, &obs)) {
+			munmap(mapping, sizeof(GymShared));
+			return 1;
+		}
+		latencies_us.emplace_back(std::chrono::duration< float, std::micro >(std::chrono::steady_clock::now() - before).count());
+	}
+
+	action.command = GymAction::Quit;
+	shared->actions[sent % GymShared::RingSize] = action;
+	sent += 1;
+	gym_publish(shared->actions_written, sent);
+	munmap(mapping, sizeof(GymShared));
+
+	uint32_t live = 0;
+	for (uint32_t b = 0; b < obs.brick_count; ++b) {
+		if (obs.live_bricks[b / 32] & (1u << (b % 32))) live += 1;
+	}
+	std::cout << "Final state: step " << obs.step << ", area " << obs.area << ", ball (" << obs.ball[0] << ", " << obs.ball[1] << "), "
+		<< live << "/" << obs.brick_count << " bricks, " << resets << " resets." << std::endl;
+
+	if (!latencies_us.empty()) {
+		std::sort(latencies_us.begin(), latencies_us.end());
+		auto percentile = [&](float p) {
+			return latencies_us[std::min(latencies_us.size() - 1, size_t(p * latencies_us.size()))];
+		};
+		std::cout << "Step round trip over " << latencies_us.size() << " steps: "
+			<< "p50 " << percentile(0.5f) << " us, "
+			<< "p99 " << percentile(0.99f) << " us, "
+			<< "max " << latencies_us.back() << " us." << std::endl;
+	}
+	return 0;
+}
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <stdexcept>
 #include <vector>
 
 #define LOG_ERROR( X ) std::cerr << X << std::endl
@@ -57,36 +58,41 @@ static void user_flush_data(png_structp png_ptr) {
 }
 
 
-bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
-	assert(data);
-	uint32_t local_width, local_height;
-	if (width == nullptr) width = &local_width;
-	if (height == nullptr) height = &local_height;
-	*width = *height = 0;
-	data->clear();
-	//..... load file ......
-	//Load a png file, as per the libpng docs:
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
+//----- streaming reads -----
 
-	png_set_read_fn(png, &from, user_read_data);
+PNGRowReader::PNGRowReader(std::string const &filename) {
+	file.reset(new std::ifstream(filename.c_str(), std::ios::binary));
+	if (!*file) {
+		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
+	}
+	start(*file);
+}
+
+PNGRowReader::PNGRowReader(std::istream &from) {
+	start(from);
+}
 
+PNGRowReader::~PNGRowReader() {
+	if (png) png_destroy_read_struct(&png, &info, NULL);
+}
+
+void PNGRowReader::start(std::istream &from) {
+	//Load a png file, as per the libpng docs:
+	png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
 	if (!png) {
-		LOG_ERROR("  cannot alloc read struct.");
-		return false;
+		throw std::runtime_error("Cannot allocate PNG read struct.");
 	}
-	png_infop info = png_create_info_struct(png);
+	png_set_read_fn(png, &from, user_read_data);
+
+	info = png_create_info_struct(png);
 	if (!info) {
-		LOG_ERROR("  cannot alloc info struct.");
 		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
-		return false;
+		throw std::runtime_error("Cannot allocate PNG info struct.");
 	}
-	png_bytep *row_pointers = NULL;
+	//(errors here mean the constructor throws, and the destructor never runs, so clean up first)
 	if (setjmp(png_jmpbuf(png))) {
-		LOG_ERROR("  png interal error.");
 		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
-		if (row_pointers != NULL) delete[] row_pointers;
-		data->clear();
-		return false;
+		throw std::runtime_error("Failed to read PNG header.");
 	}
 	//not needed with custom read/write functions: png_init_io(png, NULL);
 	png_read_info(png, info);
@@ -104,26 +110,93 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 		png_set_strip_16(png);
 	//Ok, should be 32-bit RGBA now.
 
+	//interlaced images come in several passes, each filling in more of every row:
+	interlaced = (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE);
+	passes = uint32_t(png_set_interlace_handling(png));
+
 	png_read_update_info(png, info);
 	size_t rowbytes = png_get_rowbytes(png, info);
 	//Make sure it's the format we think it is...
-	assert(rowbytes == w*sizeof(uint32_t));
+	if (rowbytes != w*sizeof(uint32_t)) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		throw std::runtime_error("PNG rows didn't convert to 32-bit RGBA.");
+	}
 
-	data->resize(w*h);
-	row_pointers = new png_bytep[h];
-	for (unsigned int r = 0; r < h; ++r) {
-		if (origin == LowerLeftOrigin) {
-			row_pointers[h-1-r] = (png_bytep)(&(*data)[r*w]);
-		} else {
-			row_pointers[r] = (png_bytep)(&(*data)[r*w]);
+	size = glm::uvec2(w, h);
+}
+
+void PNGRowReader::read_row(glm::u8vec4 *pixels) {
+	if (interlaced) {
+		throw std::runtime_error("Interlaced PNGs can't be read a row at a time.");
+	}
+	if (rows_read >= size.y) {
+		throw std::runtime_error("Read past the last row of a PNG.");
+	}
+	if (setjmp(png_jmpbuf(png))) {
+		throw std::runtime_error("Failed to read PNG row " + std::to_string(rows_read) + ".");
+	}
+	png_read_row(png, reinterpret_cast< png_bytep >(pixels), NULL);
+	rows_read += 1;
+}
+
+void PNGRowReader::read_image(glm::u8vec4 *data, OriginLocation origin) {
+	if (setjmp(png_jmpbuf(png))) {
+		throw std::runtime_error("Failed to read PNG image.");
+	}
+	//(rows_read is always zero for interlaced images, so each pass covers every row)
+	for (uint32_t pass = 0; pass < passes; ++pass) {
+		for (uint32_t r = rows_read; r < size.y; ++r) {
+			glm::u8vec4 *row = data + size_t(origin == LowerLeftOrigin ? size.y - 1 - r : r) * size.x;
+			png_read_row(png, reinterpret_cast< png_bytep >(row), NULL);
 		}
 	}
-	png_read_image(png, row_pointers);
-	png_destroy_read_struct(&png, &info, NULL);
-	delete[] row_pointers;
+	rows_read = size.y;
+}
 
-	*width = w;
-	*height = h;
+void load_png_rows(std::string filename, OriginLocation origin,
+	std::function< void(glm::uvec2 const &size) > const &header,
+	std::function< void(uint32_t y, glm::u8vec4 const *pixels) > const &row) {
+	PNGRowReader reader(filename);
+	if (header) header(reader.size);
+	auto y_of = [&reader, origin](uint32_t r) {
+		return (origin == LowerLeftOrigin ? reader.size.y - 1 - r : r);
+	};
+	if (reader.interlaced) {
+		//rows aren't final until the last pass, so interlaced images are decoded whole:
+		vector< glm::u8vec4 > data(size_t(reader.size.x) * reader.size.y);
+		reader.read_image(data.data(), UpperLeftOrigin);
+		for (uint32_t r = 0; r < reader.size.y; ++r) {
+			row(y_of(r), data.data() + size_t(r) * reader.size.x);
+		}
+		return;
+	}
+	vector< glm::u8vec4 > pixels(reader.size.x);
+	for (uint32_t r = 0; r < reader.size.y; ++r) {
+		reader.read_row(pixels.data());
+		row(y_of(r), pixels.data());
+	}
+}
+
+
+bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
+	assert(data);
+	uint32_t local_width, local_height;
+	if (width == nullptr) width = &local_width;
+	if (height == nullptr) height = &local_height;
+	*width = *height = 0;
+	data->clear();
+	//decode straight into 'data' (no row pointer array or second copy needed):
+	try {
+		PNGRowReader reader(from);
+		data->resize(size_t(reader.size.x) * reader.size.y);
+		reader.read_image(data->data(), origin);
+		*width = reader.size.x;
+		*height = reader.size.y;
+	} catch (std::exception const &e) {
+		LOG_ERROR("  " << e.what());
+		data->clear();
+		return false;
+	}
 	return true;
 }
 
@@ -2,6 +2,9 @@
 
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <istream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -18,3 +21,38 @@ enum OriginLocation {
 //NOTE: load_png will throw on error
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
+
+//Streaming version of load_png, for images too big to want extra full-size copies of:
+// reads the header on construction, then decodes rows (top row first, 32-bit RGBA like load_png)
+// into memory supplied by the caller -- one row at a time, or a whole image at a time
+// (e.g., straight into a mapped GL_PIXEL_UNPACK_BUFFER).
+//NOTE: everything here throws on error
+struct PNGRowReader {
+	PNGRowReader(std::string const &filename);
+	PNGRowReader(std::istream &from); //'from' must outlive the reader
+	~PNGRowReader();
+	PNGRowReader(PNGRowReader const &) = delete;
+	PNGRowReader &operator=(PNGRowReader const &) = delete;
+
+	glm::uvec2 size = glm::uvec2(0);
+	bool interlaced = false; //interlaced images can only be read with read_image()
+	uint32_t rows_read = 0;
+
+	//decode the next row (size.x pixels):
+	void read_row(glm::u8vec4 *pixels);
+	//decode every remaining row into 'data' (size.x * size.y pixels, with 'origin' saying where row 0 goes):
+	void read_image(glm::u8vec4 *data, OriginLocation origin);
+
+	//----- internals -----
+	std::unique_ptr< std::istream > file; //if opened by filename
+	struct png_struct_def *png = nullptr;
+	struct png_info_def *info = nullptr;
+	uint32_t passes = 1; //(more for interlaced images)
+	void start(std::istream &from);
+};
+
+//call 'row' with each row of a PNG, top row first ('y' counts from the bottom for LowerLeftOrigin),
+// after calling 'header' with the image size; only one row is in memory at a time:
+void load_png_rows(std::string filename, OriginLocation origin,
+	std::function< void(glm::uvec2 const &size) > const &header,
+	std::function< void(uint32_t y, glm::u8vec4 const *pixels) > const &row);
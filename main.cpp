@@ -10,6 +10,25 @@
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for recording and replaying play sessions:
+#include "InputRecording.hpp"
+
+//for driving the game from another process:
+#include "GymServer.hpp"
+
+//for simulating on a separate thread:
+#include "PongSimThread.hpp"
+
+//for measuring input latency:
+#include "LatencyTracker.hpp"
+
+//for deciding when to start the next frame:
+#include "FramePacer.hpp"
+
+//for rendering without a window:
+#include "HeadlessGL.hpp"
+#include "SoftRasterizer.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -19,6 +38,118 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <random>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+//run a recording through PongMode::update as fast as possible without creating a window:
+static int replay_headless(InputRecording const &recording, uint32_t extra_balls) {
+	PongMode pong(false);
+	pong.extra_ball_count = extra_balls;
+	const char *title = "";
+	Mode::Window_settings window_settings = Mode::Window_settings(glm::uvec2(800, 800), glm::uvec2(0, 0), 1.0f, &title);
+
+	std::chrono::high_resolution_clock::duration update_time(0);
+	for (auto const &frame : recording.frames) {
+		pong.absolute_mouse_pos = frame.mouse;
+		pong.rng.seed(frame.seed);
+		auto before = std::chrono::high_resolution_clock::now();
+		pong.update(frame.elapsed, window_settings);
+		update_time += std::chrono::high_resolution_clock::now() - before;
+	}
+
+	double update_ms = std::chrono::duration< double, std::milli >(update_time).count();
+	std::cout << "Replayed " << recording.frames.size() << " frames; update() took " << update_ms << " ms total";
+	if (!recording.frames.empty()) {
+		std::cout << " (" << (update_ms * 1000.0 / recording.frames.size()) << " us/frame)";
+	}
+	std::cout << "." << std::endl;
+
+	if (pong.state_checksum() != recording.final_checksum) {
+		std::cerr << "Replay DIVERGED from recording (checksum " << pong.state_checksum() << " vs recorded " << recording.final_checksum << ")." << std::endl;
+		return 1;
+	}
+	std::cout << "Replay matches recording." << std::endl;
+	return 0;
+}
+
+//draw PongMode offscreen (no window or display needed) and save the last frame as a png:
+// plays 'recording' if it has frames, otherwise simulates 'frames' steps of 1/60th second with the paddles following the ball.
+// 'software' draws with SoftRasterizer instead of OpenGL (so no GL driver is needed either).
+static int render_headless(std::string const &filename, glm::uvec2 const &size, InputRecording const &recording, uint32_t frames, uint32_t extra_balls, bool software) {
+	std::unique_ptr< HeadlessGL > headless;
+	std::unique_ptr< SoftRasterizer > soft;
+	if (software) {
+		soft.reset(new SoftRasterizer());
+		soft->resize(size);
+	} else {
+		headless.reset(new HeadlessGL(size));
+		headless->bind();
+	}
+
+	int result = 0;
+	{ //(PongMode's GL resources need to go before the context does)
+		PongMode pong(!software);
+		pong.extra_ball_count = extra_balls;
+		const char *title = "";
+		Mode::Window_settings window_settings = Mode::Window_settings(size, glm::uvec2(0, 0), 1.0f, &title);
+
+		std::chrono::high_resolution_clock::duration draw_time(0);
+		uint32_t draws = 0;
+		auto draw = [&]() {
+			pong.frame_arena.reset();
+			auto before = std::chrono::high_resolution_clock::now();
+			if (soft) {
+				PongMode::DrawList list(pong.frame_arena);
+				pong.build_draw_list(size, 1.0f, &list);
+				soft->render(list);
+			} else {
+				pong.draw(size, 1.0f);
+				headless->finish(); //(include the GPU's work in the time)
+			}
+			draw_time += std::chrono::high_resolution_clock::now() - before;
+			draws += 1;
+		};
+
+		if (!recording.frames.empty()) {
+			for (auto const &frame : recording.frames) {
+				pong.absolute_mouse_pos = frame.mouse;
+				pong.rng.seed(frame.seed);
+				pong.frame_arena.reset();
+				pong.update(frame.elapsed, window_settings);
+				draw();
+			}
+			if (pong.state_checksum() != recording.final_checksum) {
+				std::cerr << "Replay DIVERGED from recording (checksum " << pong.state_checksum() << " vs recorded " << recording.final_checksum << ")." << std::endl;
+				result = 1;
+			}
+		} else {
+			for (uint32_t i = 0; i < frames; ++i) {
+				pong.absolute_mouse_pos = glm::vec2(0.0f); //(mouse at the camera, which follows the ball)
+				pong.frame_arena.reset();
+				pong.update(1.0f / 60.0f, window_settings);
+				draw();
+			}
+			if (draws == 0) draw();
+		}
+
+		double draw_ms = std::chrono::duration< double, std::milli >(draw_time).count();
+		std::cout << "Drew " << draws << " frames at " << size.x << "x" << size.y << (soft ? " (software)" : "") << "; took " << draw_ms << " ms total"
+			<< " (" << (draw_ms * 1000.0 / draws) << " us/frame)." << std::endl;
+	}
+
+	std::vector< glm::u8vec4 > data;
+	if (soft) {
+		data = soft->pixels;
+	} else {
+		headless->read_pixels(&data);
+	}
+	std::cout << "Saving last frame to '" << filename << "'." << std::endl;
+	save_png(filename, size, data.data(), LowerLeftOrigin);
+	return result;
+}
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,6 +157,158 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	std::string record_filename = ""; //if non-empty, record the session to this file
+	std::string replay_filename = ""; //if non-empty, replay the session stored in this file
+	bool headless = false; //replay without a window
+	std::string gym_name = ""; //if non-empty, serve the game over shared memory with this name instead of opening a window
+	float sim_rate = 0.0f; //if non-zero, simulate at this many steps per second on a separate thread
+	float fixed_step = 0.0f; //if non-zero, call update with exactly this many seconds (as often as needed) instead of once per frame
+	uint32_t max_steps_per_frame = 8; //at most this many fixed steps per frame; any extra time is dropped
+	bool measure_latency = false; //report mouse-to-screen latency
+	bool use_mouse_state = false; //read the mouse position once per frame instead of from motion events
+	FramePacer::Target pace_target = FramePacer::VSync; //how to pace frames
+	float pace_rate = 60.0f; //frames per second for FramePacer::FixedRate
+	float frame_stats_interval = 0.0f; //if non-zero, log frame time stats this often (seconds)
+	uint32_t extra_balls = 0; //number of extra balls in the main area
+	bool balls_given = false; //(replays take the count from the recording, so --balls has to agree with it)
+	std::string render_filename = ""; //if non-empty, render offscreen (no window) and save the last frame here
+	glm::uvec2 render_size = glm::uvec2(800, 800); //framebuffer size for --render
+	uint32_t render_frames = 0; //steps to simulate (and draw) before saving, for --render without --replay
+	bool render_software = false; //--render with SoftRasterizer instead of OpenGL
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--record" && i + 1 < argc) {
+			record_filename = argv[++i];
+		} else if (arg == "--replay" && i + 1 < argc) {
+			replay_filename = argv[++i];
+		} else if (arg == "--headless") {
+			headless = true;
+		} else if (arg == "--gym" && i + 1 < argc) {
+			gym_name = argv[++i];
+		} else if (arg == "--sim-rate" && i + 1 < argc) {
+			sim_rate = float(std::atof(argv[++i]));
+			if (!(sim_rate > 0.0f)) {
+				std::cerr << "--sim-rate expects a positive number of steps per second." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--fixed-step" && i + 1 < argc) {
+			float rate = float(std::atof(argv[++i]));
+			if (!(rate > 0.0f)) {
+				std::cerr << "--fixed-step expects a positive number of steps per second." << std::endl;
+				return 1;
+			}
+			fixed_step = 1.0f / rate;
+		} else if (arg == "--max-steps" && i + 1 < argc) {
+			int steps = std::atoi(argv[++i]);
+			if (steps <= 0) {
+				std::cerr << "--max-steps expects a positive number of steps per frame." << std::endl;
+				return 1;
+			}
+			max_steps_per_frame = uint32_t(steps);
+		} else if (arg == "--latency") {
+			measure_latency = true;
+		} else if (arg == "--mouse-state") {
+			use_mouse_state = true;
+		} else if (arg == "--pace" && i + 1 < argc) {
+			std::string pace = argv[++i];
+			if (pace == "vsync") {
+				pace_target = FramePacer::VSync;
+			} else if (pace == "uncapped") {
+				pace_target = FramePacer::Uncapped;
+			} else {
+				pace_target = FramePacer::FixedRate;
+				pace_rate = float(std::atof(pace.c_str()));
+				if (!(pace_rate > 0.0f)) {
+					std::cerr << "--pace expects 'vsync', 'uncapped', or a positive number of frames per second." << std::endl;
+					return 1;
+				}
+			}
+		} else if (arg == "--balls" && i + 1 < argc) {
+			int balls = std::atoi(argv[++i]);
+			if (balls < 0) {
+				std::cerr << "--balls expects a non-negative number of extra balls." << std::endl;
+				return 1;
+			}
+			extra_balls = uint32_t(balls);
+			balls_given = true;
+		} else if (arg == "--frame-stats" && i + 1 < argc) {
+			frame_stats_interval = float(std::atof(argv[++i]));
+			if (!(frame_stats_interval > 0.0f)) {
+				std::cerr << "--frame-stats expects a positive number of seconds." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--render" && i + 1 < argc) {
+			render_filename = argv[++i];
+		} else if (arg == "--software") {
+			render_software = true;
+		} else if (arg == "--size" && i + 1 < argc) {
+			unsigned w = 0, h = 0;
+			if (std::sscanf(argv[++i], "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+				std::cerr << "--size expects a size like 800x600." << std::endl;
+				return 1;
+			}
+			render_size = glm::uvec2(w, h);
+		} else if (arg == "--frames" && i + 1 < argc) {
+			int frames = std::atoi(argv[++i]);
+			if (frames < 0) {
+				std::cerr << "--frames expects a non-negative number of frames." << std::endl;
+				return 1;
+			}
+			render_frames = uint32_t(frames);
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--record <file>] [--replay <file> [--headless]] [--gym <name>] [--sim-rate <hz>] [--fixed-step <hz> [--max-steps <n>]] [--latency] [--mouse-state] [--pace vsync|uncapped|<fps>] [--frame-stats <seconds>] [--balls <n>] [--render <file.png> [--size <w>x<h>] [--frames <n>] [--software]]" << std::endl;
+			return 1;
+		}
+	}
+	if (headless && replay_filename == "") {
+		std::cerr << "--headless only makes sense with --replay." << std::endl;
+		return 1;
+	}
+	if (record_filename != "" && replay_filename != "") {
+		std::cerr << "Can't record and replay at the same time." << std::endl;
+		return 1;
+	}
+	if (sim_rate != 0.0f && (record_filename != "" || replay_filename != "")) {
+		std::cerr << "--sim-rate can't be combined with recording or replay." << std::endl;
+		return 1;
+	}
+
+	if (fixed_step != 0.0f && (sim_rate != 0.0f || replay_filename != "")) {
+		//(replays repeat the recorded update steps exactly, whatever they were)
+		std::cerr << "--fixed-step can't be combined with --sim-rate or replay." << std::endl;
+		return 1;
+	}
+
+	if (render_filename != "" && (headless || record_filename != "" || gym_name != "" || sim_rate != 0.0f || fixed_step != 0.0f)) {
+		std::cerr << "--render can only be combined with --replay, --balls, --size, --frames, and --software." << std::endl;
+		return 1;
+	}
+	if (render_filename == "" && (render_size != glm::uvec2(800, 800) || render_frames != 0 || render_software)) {
+		std::cerr << "--size, --frames, and --software only make sense with --render." << std::endl;
+		return 1;
+	}
+
+	if (gym_name != "") {
+		return run_gym_server(gym_name);
+	}
+
+	InputRecording recording;
+	if (replay_filename != "") {
+		recording.load(replay_filename);
+		if (balls_given && extra_balls != recording.extra_ball_count) {
+			std::cerr << "--balls " << extra_balls << " doesn't match the " << recording.extra_ball_count << " extra balls '" << replay_filename << "' was recorded with." << std::endl;
+			return 1;
+		}
+		extra_balls = recording.extra_ball_count;
+		if (headless) return replay_headless(recording, extra_balls);
+	}
+
+	if (render_filename != "") {
+		return render_headless(render_filename, render_size, recording, render_frames, extra_balls, render_software);
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -76,19 +359,50 @@ int main(int argc, char **argv) {
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
 	init_GL();
 
-	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
-		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
-		if (SDL_GL_SetSwapInterval(1) != 0) {
-			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
+	//Set up frame pacing (by default VSYNC + Late Swap, which prevents crazy FPS):
+	FramePacer pacer(pace_target, pace_rate);
+	pacer.log_interval = frame_stats_interval;
+	{
+		SDL_DisplayMode mode;
+		float display_hz = 0.0f;
+		if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0) {
+			display_hz = float(mode.refresh_rate);
 		}
+		pacer.apply_swap_interval(display_hz);
 	}
 
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PongMode >());
+	std::shared_ptr< PongMode > pong = std::make_shared< PongMode >();
+	pong->extra_ball_count = extra_balls;
+	Mode::set_current(pong);
+
+	//recording / replay state:
+	std::mt19937 seed_generator{std::random_device()()}; //source of per-frame seeds when recording
+	size_t replay_frame = 0; //next frame of 'recording' to replay
+
+	//when simulating on a separate thread, 'pong' only handles input and draws snapshots:
+	std::unique_ptr< PongSimThread > sim_thread;
+	const char *sim_title = nullptr; //window title requested by the simulation thread
+	if (sim_rate != 0.0f) {
+		sim_thread.reset(new PongSimThread(sim_rate, extra_balls));
+	}
+
+	std::unique_ptr< LatencyTracker > latency;
+	if (measure_latency) {
+		latency.reset(new LatencyTracker());
+	}
+
+	//mouse motion bookkeeping:
+	uint64_t mouse_motion_received = 0; //SDL_MOUSEMOTION events from SDL
+	uint64_t mouse_motion_dispatched = 0; //motion events passed to the mode (after coalescing)
+	glm::ivec2 polled_mouse = glm::ivec2(-1, -1); //last position read with --mouse-state
+
+	//fixed-step state:
+	float step_accumulator = 0.0f; //time not yet simulated
+	float draw_alpha = 1.0f; //how far between the last two updates to draw
 
 	//------------ main loop ------------
 
@@ -121,19 +435,16 @@ int main(int argc, char **argv) {
 		//  by performing three steps:
 
 		{ //(1) process any events that are pending
-			static SDL_Event evt;
-			while (SDL_PollEvent(&evt) == 1) {
-				//handle resizing:
-				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-					on_resize();
-				}
-				//handle input:
+			//hand one event to the current mode (or handle it here):
+			auto dispatch = [&](SDL_Event const &evt) {
+				if (evt.type == SDL_MOUSEMOTION) mouse_motion_dispatched += 1;
 				bool QUIT = false;
 				if (Mode::current && Mode::current->handle_event(evt, window_size, &QUIT)) {
 					// mode handled it; great
 				} else if (evt.type == SDL_QUIT) {
 					Mode::set_current(nullptr);
-					break;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					pacer.print_stats(std::cout);
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
 					std::string filename = "screenshot.png";
@@ -151,12 +462,69 @@ int main(int argc, char **argv) {
 				}
 				if (QUIT) {
 					Mode::set_current(nullptr);
-					break;
+				}
+			};
+
+			//only the newest mouse position matters, so motion events are coalesced into one
+			// (which is dispatched before any other event, to keep ordering intact):
+			static SDL_Event motion;
+			bool have_motion = false;
+			auto flush_motion = [&]() {
+				if (!have_motion) return;
+				have_motion = false;
+				dispatch(motion);
+			};
+
+			static SDL_Event evt;
+			while (SDL_PollEvent(&evt) == 1) {
+				//handle resizing:
+				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+					on_resize();
+				}
+				if (evt.type == SDL_MOUSEMOTION) {
+					mouse_motion_received += 1;
+					//when replaying, mouse input comes from the recording instead:
+					if (replay_filename != "") continue;
+					if (latency) latency->note_input(evt.motion.timestamp);
+					//when polling mouse state, the position is read after the event loop:
+					if (use_mouse_state) continue;
+					if (have_motion) {
+						evt.motion.xrel += motion.motion.xrel;
+						evt.motion.yrel += motion.motion.yrel;
+					}
+					motion = evt;
+					have_motion = true;
+					continue;
+				}
+				//handle input:
+				flush_motion();
+				if (Mode::current) dispatch(evt);
+				if (!Mode::current) break;
+			}
+			if (Mode::current) flush_motion();
+			if (Mode::current && use_mouse_state && replay_filename == "") {
+				//read the mouse once per frame, and pass it along as a motion event if it moved:
+				int x, y;
+				SDL_GetMouseState(&x, &y);
+				if (x != polled_mouse.x || y != polled_mouse.y) {
+					SDL_Event polled;
+					std::memset(&polled, 0, sizeof(polled));
+					polled.type = SDL_MOUSEMOTION;
+					polled.motion.timestamp = SDL_GetTicks();
+					polled.motion.x = x;
+					polled.motion.y = y;
+					polled.motion.xrel = x - polled_mouse.x;
+					polled.motion.yrel = y - polled_mouse.y;
+					polled_mouse = glm::ivec2(x, y);
+					dispatch(polled);
 				}
 			}
 			if (!Mode::current) break;
 		}
 
+		//start the frame with an empty scratch arena:
+		Mode::current->frame_arena.reset();
+
 		{ //(2) call the current mode's "update" function to deal with elapsed time:
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
@@ -169,7 +537,60 @@ int main(int argc, char **argv) {
 
 			//set the new window size & position, if the update function requested it.
 			Mode::Window_settings window_settings = Mode::Window_settings(window_size, window_position, window_opacity, window_title);
-			Mode::current->update(elapsed, window_settings);
+
+			//feed in recorded input, or record the input that is about to be used, then update:
+			auto step = [&](float step_elapsed) {
+				if (replay_filename != "") {
+					InputRecording::Frame const &frame = recording.frames[replay_frame++];
+					step_elapsed = frame.elapsed;
+					pong->absolute_mouse_pos = frame.mouse;
+					pong->rng.seed(frame.seed);
+				} else if (record_filename != "") {
+					InputRecording::Frame frame;
+					frame.elapsed = step_elapsed;
+					frame.mouse = pong->absolute_mouse_pos;
+					frame.seed = uint32_t(seed_generator());
+					pong->rng.seed(frame.seed);
+					recording.frames.emplace_back(frame);
+				}
+				Mode::current->update(step_elapsed, window_settings);
+			};
+
+			if (replay_filename != "" && replay_frame >= recording.frames.size()) {
+				std::cout << "Replay finished; state " << (pong->state_checksum() == recording.final_checksum ? "matches" : "DIVERGED from") << " recording." << std::endl;
+				Mode::set_current(nullptr);
+				break;
+			}
+
+			if (sim_thread) {
+				//simulation happens elsewhere; just pass along input and pick up its latest state:
+				sim_thread->set_mouse(pong->absolute_mouse_pos, (latency ? latency->newest_input : 0));
+				PongMode::Snapshot const &latest = sim_thread->load_into(pong.get());
+				//only input the drawn snapshot was stepped with has reached the screen:
+				if (latency) latency->input_used(sim_thread->drawn_input_time);
+				window_settings.opacity = latest.opacity;
+				if (latest.title) {
+					sim_title = latest.title;
+					window_settings.title = &sim_title;
+				}
+			} else if (fixed_step != 0.0f) {
+				//run as many whole steps as have accumulated (within budget), and draw the remainder as an interpolation:
+				step_accumulator += elapsed;
+				uint32_t steps = 0;
+				while (step_accumulator >= fixed_step && steps < max_steps_per_frame && Mode::current) {
+					step(fixed_step);
+					step_accumulator -= fixed_step;
+					++steps;
+				}
+				//a frame that didn't step hasn't read the mouse, so its input is still pending:
+				if (latency && steps > 0) latency->input_used();
+				//over budget: drop the backlog rather than falling further behind:
+				if (step_accumulator >= fixed_step) step_accumulator = std::fmod(step_accumulator, fixed_step);
+				draw_alpha = step_accumulator / fixed_step;
+			} else {
+				step(elapsed);
+				if (latency) latency->input_used();
+			}
 
 			bool updated_window = false;
 			//set new window position
@@ -200,16 +621,39 @@ int main(int argc, char **argv) {
 
 		{ //(3) call the current mode's "draw" function to produce output:
 		
-			Mode::current->draw(drawable_size);
+			Mode::current->draw(drawable_size, draw_alpha);
 		}
 
+		if (latency) latency->before_swap();
+
 		//Wait until the recently-drawn frame is shown before doing it all again:
 		SDL_GL_SwapWindow(window);
+
+		if (latency) latency->after_swap();
+
+		//wait for the next frame (if needed) and keep track of frame times:
+		pacer.end_frame();
 	}
 
 
 	//------------  teardown ------------
 
+	sim_thread.reset();
+
+	if (latency) {
+		latency->report(std::cout);
+		latency.reset();
+		std::cout << "Mouse motion: " << mouse_motion_received << " events received, " << mouse_motion_dispatched << " dispatched." << std::endl;
+	}
+
+	if (record_filename != "") {
+		recording.final_checksum = pong->state_checksum();
+		recording.extra_ball_count = extra_balls;
+		recording.save(record_filename);
+		std::cout << "Recorded " << recording.frames.size() << " frames to '" << record_filename << "'." << std::endl;
+	}
+	pong.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
@@ -0,0 +1,412 @@
+//Self-checks for code that can be subtly wrong without anything looking wrong on screen
+// (e.g., a SIMD path that disagrees with its scalar fallback at odd sizes).
+//
+// usage: pongoria-selftest [--filter <substring>] [--temp <directory>]
+//  --filter <substring>   only run checks whose names contain this
+//  --temp <directory>     where checks may write (and then remove) scratch files (default: current directory)
+// prints ok or FAILED (with the first problem found) for each check, and exits with 1 if any failed,
+//  so it can gate CI.
+// (checks that need OpenGL use HeadlessGL, so only run on Linux)
+
+#include "MipChain.hpp"
+#include "CompressedTexture.hpp"
+#include "HeadlessGL.hpp"
+#include "PCG32.hpp"
+#include "load_save_png.hpp"
+
+#include <png.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void usage(char const *name) {
+	std::cerr << "Usage:\n\t" << name << " [--filter <substring>] [--temp <directory>]" << std::endl;
+}
+
+static std::string temp_dir = ".";
+
+static std::string to_string(glm::u8vec4 const &c) {
+	std::ostringstream str;
+	str << "(" << int(c.r) << ", " << int(c.g) << ", " << int(c.b) << ", " << int(c.a) << ")";
+	return str.str();
+}
+
+static std::string to_string(glm::uvec2 const &size) {
+	return std::to_string(size.x) + "x" + std::to_string(size.y);
+}
+
+//odd, 1-wide, 1-tall, and a few sizes that leave remainders after the four-at-a-time path:
+static glm::uvec2 const TestSizes[] = {
+	glm::uvec2(1, 1), glm::uvec2(1, 2), glm::uvec2(2, 1), glm::uvec2(1, 37), glm::uvec2(37, 1),
+	glm::uvec2(2, 2), glm::uvec2(3, 3), glm::uvec2(7, 5), glm::uvec2(8, 8), glm::uvec2(9, 9),
+	glm::uvec2(15, 16), glm::uvec2(33, 17), glm::uvec2(255, 3), glm::uvec2(3, 255), glm::uvec2(1024, 1),
+	glm::uvec2(640, 480),
+};
+
+static std::vector< glm::u8vec4 > random_image(glm::uvec2 const &size, PCG32 &rng) {
+	std::vector< glm::u8vec4 > data(size_t(size.x) * size.y);
+	for (auto &px : data) {
+		uint32_t bits = rng();
+		px = glm::u8vec4(bits & 0xff, (bits >> 8) & 0xff, (bits >> 16) & 0xff, bits >> 24);
+	}
+	return data;
+}
+
+//----- MipChain -----
+
+//the 2x2 box filter MipChain::build() is meant to implement, one pixel at a time:
+static void reference_downsample(glm::uvec2 const &src_size, std::vector< glm::u8vec4 > const &src, glm::uvec2 *dst_size, std::vector< glm::u8vec4 > *dst) {
+	*dst_size = glm::uvec2(std::max(src_size.x / 2U, 1U), std::max(src_size.y / 2U, 1U));
+	dst->resize(size_t(dst_size->x) * dst_size->y);
+	for (uint32_t y = 0; y < dst_size->y; ++y) {
+		for (uint32_t x = 0; x < dst_size->x; ++x) {
+			uint32_t xs[2] = { std::min(2 * x, src_size.x - 1), std::min(2 * x + 1, src_size.x - 1) };
+			uint32_t ys[2] = { std::min(2 * y, src_size.y - 1), std::min(2 * y + 1, src_size.y - 1) };
+			glm::u8vec4 &out = (*dst)[size_t(y) * dst_size->x + x];
+			for (uint32_t c = 0; c < 4; ++c) {
+				uint32_t sum = 2; //(round to nearest)
+				for (uint32_t sy : ys) {
+					for (uint32_t sx : xs) {
+						sum += src[size_t(sy) * src_size.x + sx][c];
+					}
+				}
+				out[c] = uint8_t(sum / 4);
+			}
+		}
+	}
+}
+
+//compare 'chain' with levels built by reference_downsample:
+static std::string compare_mip_chain(MipChain const &chain) {
+	glm::uvec2 size = chain.sizes[0];
+	std::vector< glm::u8vec4 > expected = chain.levels[0];
+	for (uint32_t level = 1; ; ++level) {
+		if (size == glm::uvec2(1, 1)) {
+			if (chain.levels.size() != level) return to_string(chain.sizes[0]) + ": built " + std::to_string(chain.levels.size()) + " levels, expected " + std::to_string(level);
+			return "";
+		}
+		glm::uvec2 next_size;
+		std::vector< glm::u8vec4 > next;
+		reference_downsample(size, expected, &next_size, &next);
+		if (level >= chain.levels.size()) return to_string(chain.sizes[0]) + ": stopped after " + std::to_string(level) + " levels";
+		if (chain.sizes[level] != next_size) return to_string(chain.sizes[0]) + " level " + std::to_string(level) + ": is " + to_string(chain.sizes[level]) + ", expected " + to_string(next_size);
+		for (size_t i = 0; i < next.size(); ++i) {
+			if (chain.levels[level][i] != next[i]) {
+				return to_string(chain.sizes[0]) + " level " + std::to_string(level) + " pixel (" + std::to_string(i % next_size.x) + ", " + std::to_string(i / next_size.x) + "): "
+					+ to_string(chain.levels[level][i]) + ", expected " + to_string(next[i]);
+			}
+		}
+		size = next_size;
+		expected = std::move(next);
+	}
+}
+
+//MipChain::build() (SSE2 where available) against the scalar reference, built singly and with build_mip_chains:
+static std::string check_mip_chain() {
+	PCG32 rng(1);
+	std::vector< MipChain > chains;
+	for (auto const &size : TestSizes) {
+		chains.emplace_back(size, random_image(size, rng));
+	}
+	for (auto &chain : chains) {
+		chain.build();
+		std::string problem = compare_mip_chain(chain);
+		if (problem != "") return problem;
+	}
+
+	std::vector< MipChain > threaded;
+	std::vector< MipChain * > pointers;
+	for (auto const &chain : chains) {
+		threaded.emplace_back(chain.sizes[0], std::vector< glm::u8vec4 >(chain.levels[0]));
+	}
+	for (auto &chain : threaded) pointers.emplace_back(&chain);
+	build_mip_chains(pointers, 4);
+	for (size_t i = 0; i < chains.size(); ++i) {
+		if (threaded[i].levels != chains[i].levels) return to_string(chains[i].sizes[0]) + ": build_mip_chains() differs from build()";
+	}
+	return "";
+}
+
+//----- CompressedTexture -----
+
+//what the GL driver decodes (read back with glGetTexImage) against CompressedTexture::decode(), for every format and level:
+static std::string check_compressed_decode() {
+	HeadlessGL gl(glm::uvec2(1, 1));
+
+	bool s3tc = false;
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+		if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) s3tc = true;
+	}
+	if (!s3tc) {
+		//(upload() decodes BC1/BC3 on the CPU then, so those compare decode() with itself)
+		std::cout << "  (driver lacks S3TC; only BC4 and BC5 go through the driver's decoder)" << std::endl;
+	}
+
+	PCG32 rng(2);
+	static glm::uvec2 const sizes[] = { glm::uvec2(64, 64), glm::uvec2(37, 23) };
+	static CompressedTexture::Format const formats[] = { CompressedTexture::BC1, CompressedTexture::BC3, CompressedTexture::BC4, CompressedTexture::BC5 };
+	for (auto const &size : sizes) {
+		MipChain mips(size, random_image(size, rng));
+		mips.build();
+		for (auto format : formats) {
+			CompressedTexture texture;
+			texture.encode(mips, format);
+
+			GLuint tex = 0;
+			glGenTextures(1, &tex);
+			glBindTexture(GL_TEXTURE_2D, tex);
+			texture.upload();
+
+			std::string problem = "";
+			std::vector< glm::u8vec4 > expected, got;
+			for (uint32_t level = 0; level < texture.levels.size() && problem == ""; ++level) {
+				texture.decode(level, &expected);
+				got.assign(expected.size(), glm::u8vec4(0));
+				glPixelStorei(GL_PACK_ALIGNMENT, 1);
+				glGetTexImage(GL_TEXTURE_2D, GLint(level), GL_RGBA, GL_UNSIGNED_BYTE, got.data());
+				glm::uvec2 level_size = texture.sizes[level];
+				for (size_t i = 0; i < expected.size(); ++i) {
+					//(drivers may round palette entries differently, so allow 1 either way)
+					glm::ivec4 diff = glm::abs(glm::ivec4(got[i]) - glm::ivec4(expected[i]));
+					if (std::max(std::max(diff.r, diff.g), std::max(diff.b, diff.a)) > 1) {
+						problem = "BC" + std::to_string(uint32_t(format)) + " " + to_string(size) + " level " + std::to_string(level)
+							+ " pixel (" + std::to_string(i % level_size.x) + ", " + std::to_string(i / level_size.x) + "): driver gives " + to_string(got[i])
+							+ ", decode() gives " + to_string(expected[i]);
+						break;
+					}
+				}
+			}
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glDeleteTextures(1, &tex);
+			if (problem != "") return problem;
+		}
+	}
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) return "GL error " + std::to_string(error);
+	return "";
+}
+
+//----- PNGRowReader -----
+
+//encode an 8-bit RGBA image (rows top first) as a PNG, optionally Adam7-interlaced and/or without alpha
+// (save_png only writes plain RGBA, and these are the paths PNGRowReader handles differently):
+static std::string encode_png(glm::uvec2 const &size, std::vector< glm::u8vec4 > const &data, bool interlaced, bool alpha) {
+	std::string bytes;
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info = (png ? png_create_info_struct(png) : NULL);
+	if (!png || !info || setjmp(png_jmpbuf(png))) {
+		png_destroy_write_struct(&png, &info);
+		throw std::runtime_error("Failed to encode test PNG.");
+	}
+	png_set_write_fn(png, &bytes, [](png_structp png, png_bytep data, png_size_t length) {
+		reinterpret_cast< std::string * >(png_get_io_ptr(png))->append(reinterpret_cast< char const * >(data), length);
+	}, NULL);
+	png_set_IHDR(png, info, size.x, size.y, 8, (alpha ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB),
+		(interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE), PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+	if (!alpha) png_set_filler(png, 0, PNG_FILLER_AFTER); //(drop the alpha byte of each pixel)
+	std::vector< png_bytep > rows(size.y);
+	for (uint32_t r = 0; r < size.y; ++r) {
+		rows[r] = reinterpret_cast< png_bytep >(const_cast< glm::u8vec4 * >(data.data() + size_t(r) * size.x));
+	}
+	png_write_image(png, rows.data());
+	png_write_end(png, NULL);
+	png_destroy_write_struct(&png, &info);
+	return bytes;
+}
+
+//does 'data' (with row 0 at 'origin') hold 'expected' (rows top first)?
+static std::string compare_rows(char const *what, glm::uvec2 const &size, std::vector< glm::u8vec4 > const &data, OriginLocation origin, std::vector< glm::u8vec4 > const &expected) {
+	if (data.size() != expected.size()) return std::string(what) + ": got " + std::to_string(data.size()) + " pixels, expected " + std::to_string(expected.size());
+	for (uint32_t r = 0; r < size.y; ++r) {
+		glm::u8vec4 const *row = data.data() + size_t(origin == LowerLeftOrigin ? size.y - 1 - r : r) * size.x;
+		for (uint32_t x = 0; x < size.x; ++x) {
+			if (row[x] != expected[size_t(r) * size.x + x]) {
+				return std::string(what) + ": pixel (" + std::to_string(x) + ", " + std::to_string(r) + " from the top) is " + to_string(row[x]) + ", expected " + to_string(expected[size_t(r) * size.x + x]);
+			}
+		}
+	}
+	return "";
+}
+
+//does 'run' throw?
+template< typename F >
+static bool throws(F const &run) {
+	try {
+		run();
+	} catch (std::exception const &) {
+		return true;
+	}
+	return false;
+}
+
+//PNGRowReader (row by row and whole image), load_png_rows, and load_png on plain and Adam7 PNGs, with and without alpha;
+// and truncated, non-PNG, and missing files throwing:
+static std::string check_png_rows() {
+	PCG32 rng(3);
+	std::string filename = temp_dir + "/selftest-png-rows.png";
+	struct RemoveFile { std::string name; ~RemoveFile() { std::remove(name.c_str()); } } remove_file{filename};
+
+	std::cout << "  (libpng will complain about the truncated and non-PNG files below; that's expected)" << std::endl;
+
+	static glm::uvec2 const sizes[] = { glm::uvec2(1, 1), glm::uvec2(37, 23), glm::uvec2(3, 64) };
+	for (auto const &size : sizes) {
+		for (uint32_t variant = 0; variant < 4; ++variant) {
+			bool interlaced = (variant & 1);
+			bool alpha = (variant & 2);
+			std::vector< glm::u8vec4 > expected = random_image(size, rng);
+			if (!alpha) {
+				for (auto &px : expected) px.a = 0xff;
+			}
+			std::string bytes = encode_png(size, expected, interlaced, alpha);
+			std::string name = to_string(size) + (interlaced ? " Adam7" : "") + (alpha ? " RGBA" : " RGB");
+			{
+				std::ofstream file(filename.c_str(), std::ios::binary);
+				file.write(bytes.data(), bytes.size());
+				if (!file) return "failed to write '" + filename + "' (see --temp)";
+			}
+			std::string problem;
+
+			//row by row (only plain images can be):
+			{
+				std::istringstream from(bytes);
+				PNGRowReader reader(from);
+				if (reader.size != size) return name + ": PNGRowReader says " + to_string(reader.size);
+				if (reader.interlaced != interlaced) return name + ": PNGRowReader.interlaced is wrong";
+				std::vector< glm::u8vec4 > data(size_t(size.x) * size.y);
+				if (interlaced) {
+					if (!throws([&](){ reader.read_row(data.data()); })) return name + ": read_row() didn't throw";
+				} else {
+					for (uint32_t r = 0; r < size.y; ++r) {
+						reader.read_row(data.data() + size_t(r) * size.x);
+					}
+					problem = compare_rows("read_row()", size, data, UpperLeftOrigin, expected);
+					if (problem != "") return name + " " + problem;
+					if (!throws([&](){ reader.read_row(data.data()); })) return name + ": read_row() past the end didn't throw";
+				}
+			}
+
+			//whole image, both ways up:
+			for (OriginLocation origin : { LowerLeftOrigin, UpperLeftOrigin }) {
+				std::istringstream from(bytes);
+				PNGRowReader reader(from);
+				std::vector< glm::u8vec4 > data(size_t(size.x) * size.y);
+				reader.read_image(data.data(), origin);
+				problem = compare_rows("read_image()", size, data, origin, expected);
+				if (problem != "") return name + " " + problem;
+			}
+
+			//callback, and load_png (both through the file):
+			for (OriginLocation origin : { LowerLeftOrigin, UpperLeftOrigin }) {
+				glm::uvec2 header_size = glm::uvec2(0);
+				std::vector< glm::u8vec4 > data;
+				std::vector< bool > seen(size.y, false);
+				load_png_rows(filename, origin, [&](glm::uvec2 const &size_) {
+					header_size = size_;
+					data.resize(size_t(size_.x) * size_.y);
+				}, [&](uint32_t y, glm::u8vec4 const *pixels) {
+					if (y >= size.y || seen[y]) throw std::runtime_error("row " + std::to_string(y) + " out of range or repeated");
+					seen[y] = true;
+					std::copy(pixels, pixels + size.x, data.begin() + size_t(y) * size.x);
+				});
+				if (header_size != size) return name + ": load_png_rows() header says " + to_string(header_size);
+				if (std::find(seen.begin(), seen.end(), false) != seen.end()) return name + ": load_png_rows() skipped a row";
+				problem = compare_rows("load_png_rows()", size, data, origin, expected);
+				if (problem != "") return name + " " + problem;
+
+				glm::uvec2 loaded_size;
+				load_png(filename, &loaded_size, &data, origin);
+				if (loaded_size != size) return name + ": load_png() says " + to_string(loaded_size);
+				problem = compare_rows("load_png()", size, data, origin, expected);
+				if (problem != "") return name + " " + problem;
+			}
+
+			//truncated (in the pixel data, and in the header):
+			for (size_t length : { bytes.size() / 2, size_t(20) }) {
+				std::istringstream from(bytes.substr(0, length));
+				std::vector< glm::u8vec4 > data(size_t(size.x) * size.y);
+				if (!throws([&](){ PNGRowReader reader(from); reader.read_image(data.data(), UpperLeftOrigin); })) {
+					return name + ": reading the first " + std::to_string(length) + " of " + std::to_string(bytes.size()) + " bytes didn't throw";
+				}
+			}
+		}
+	}
+
+	//not a PNG at all, and no file:
+	{
+		std::istringstream from("this is not a PNG file; it is just some text.");
+		if (!throws([&](){ PNGRowReader reader(from); })) return "reading a non-PNG didn't throw";
+	}
+	std::remove(filename.c_str());
+	if (!throws([&](){ PNGRowReader reader(filename); })) return "opening a missing file didn't throw";
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > data;
+	if (!throws([&](){ load_png(filename, &size, &data, LowerLeftOrigin); })) return "load_png() of a missing file didn't throw";
+	return "";
+}
+
+//-----
+
+struct Check {
+	char const *name;
+	std::string (*run)(); //returns the first problem found, or "" if there were none
+	bool needs_gl;
+};
+
+static Check const Checks[] = {
+	{ "mip_chain", check_mip_chain, false },
+	{ "compressed_decode", check_compressed_decode, true },
+	{ "png_rows", check_png_rows, false },
+};
+
+int main(int argc, char **argv) {
+	std::string filter = "";
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--filter" && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (arg == "--temp" && i + 1 < argc) {
+			temp_dir = argv[++i];
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	uint32_t failed = 0, passed = 0;
+	for (auto const &check : Checks) {
+		if (std::string(check.name).find(filter) == std::string::npos) continue;
+	#if !defined(__linux__)
+		if (check.needs_gl) {
+			std::cout << check.name << ": skipped (needs headless OpenGL, which is Linux only)" << std::endl;
+			continue;
+		}
+	#endif
+		std::string problem;
+		try {
+			problem = check.run();
+		} catch (std::exception const &e) {
+			problem = std::string("threw: ") + e.what();
+		}
+		if (problem == "") {
+			std::cout << check.name << ": ok" << std::endl;
+			passed += 1;
+		} else {
+			std::cout << check.name << ": FAILED (" << problem << ")" << std::endl;
+			failed += 1;
+		}
+	}
+
+	std::cout << passed << " passed, " << failed << " failed." << std::endl;
+	return (failed ? 1 : 0);
+}